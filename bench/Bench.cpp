@@ -0,0 +1,318 @@
+#include "Bench.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/**
+  * @brief A Print onto a stdio stream
+  */
+class FilePrint : public Print
+{
+public:
+  FilePrint(FILE* file) : file_(file) {};
+
+  size_t write(uint8_t c) override { return fputc(c, file_) == EOF ? 0 : 1; }
+  size_t write(const uint8_t* data, size_t size) override { return fwrite(data, 1, size, file_); }
+  void flush() override { fflush(file_); }
+
+protected:
+  FILE* file_;
+};
+
+BenchCase* BenchCase::head_ = nullptr;
+BenchCase* BenchCase::tail_ = nullptr;
+
+BenchCase::BenchCase(const char* name, BenchFunction fn) :
+  name_(name), fn_(fn), argCount_(0), next_(nullptr) {
+  link();
+}
+
+BenchCase::BenchCase(const char* name, BenchFunction fn, uint64_t arg0, uint64_t arg1, uint64_t arg2,
+  uint64_t arg3, uint64_t arg4, uint64_t arg5, uint64_t arg6, uint64_t arg7) :
+  name_(name), fn_(fn), argCount_(0), next_(nullptr) {
+  const uint64_t args[kMaxArgs] = { arg0, arg1, arg2, arg3, arg4, arg5, arg6, arg7 };
+  for (size_t i = 0; i < kMaxArgs && args[i] != 0; i++) args_[argCount_++] = args[i];
+  link();
+}
+
+// Appends, so benchmarks run in the order they are declared in a file
+void BenchCase::link() {
+  if (tail_ != nullptr) tail_->next_ = this;
+  else head_ = this;
+  tail_ = this;
+}
+
+uint64_t BenchRunner::sample(BenchFunction fn, uint64_t arg, uint64_t iterations, uint64_t& bytes) {
+  BenchState state(iterations, arg);
+  state.start_ = realNanos();
+  fn(state);
+  uint64_t end = state.stop_ != 0 ? state.stop_ : realNanos();
+  bytes = state.bytes_;
+  return end > state.start_ ? end - state.start_ : 0;
+}
+
+void BenchRunner::runCase(BenchFunction fn, uint64_t arg, const Options& options, BenchResult& result) {
+  uint64_t bytes = 0;
+  uint64_t targetNs = (uint64_t)options.minSampleMs * 1000000ull;
+
+  // Grow the iteration count until one sample takes long enough to time
+  uint64_t iterations = 1;
+  for (;;) {
+    uint64_t ns = sample(fn, arg, iterations, bytes);
+    if (ns >= targetNs || iterations >= (1ull << 40)) break;
+    uint64_t next = ns > 0 ? (uint64_t)((double)iterations * targetNs * 1.2 / ns) : iterations * 100;
+    if (next < iterations * 2) next = iterations * 2;
+    if (next > iterations * 100) next = iterations * 100;
+    iterations = next;
+  }
+
+  uint64_t warmupStart = realNanos();
+  do {
+    sample(fn, arg, iterations, bytes);
+  } while (realNanos() - warmupStart < (uint64_t)options.warmupMs * 1000000ull);
+
+  uint32_t samples = options.samples;
+  if (samples == 0) samples = 1;
+  if (samples > kMaxSamples) samples = kMaxSamples;
+  double perIteration[kMaxSamples];
+  double sum = 0;
+  for (uint32_t i = 0; i < samples; i++) {
+    double ns = (double)sample(fn, arg, iterations, bytes) / (double)iterations;
+    // Insertion sort, the sample count is small
+    uint32_t j = i;
+    while (j > 0 && perIteration[j - 1] > ns) {
+      perIteration[j] = perIteration[j - 1];
+      j--;
+    }
+    perIteration[j] = ns;
+    sum += ns;
+  }
+
+  double mean = sum / samples;
+  double squares = 0;
+  for (uint32_t i = 0; i < samples; i++) squares += (perIteration[i] - mean) * (perIteration[i] - mean);
+
+  result.iterations = iterations;
+  result.samples = samples;
+  result.minNs = perIteration[0];
+  result.maxNs = perIteration[samples - 1];
+  result.medianNs = samples & 1 ? perIteration[samples / 2] :
+    (perIteration[samples / 2 - 1] + perIteration[samples / 2]) / 2;
+  result.meanNs = mean;
+  result.stddevNs = samples > 1 ? sqrt(squares / (samples - 1)) : 0;
+  result.bytesPerIteration = bytes;
+}
+
+void BenchRunner::printResult(Print& p, const BenchResult& result) {
+  char line[200];
+  int n = snprintf(line, sizeof(line), "%-44s %12.2f ns %12.2f %12.2f  +-%5.1f%%", result.name,
+    result.medianNs, result.minNs, result.maxNs, result.meanNs > 0 ? 100.0 * result.stddevNs / result.meanNs : 0.0);
+  if (result.bytesPerIteration && n > 0 && (size_t)n < sizeof(line)) {
+    snprintf(line + n, sizeof(line) - n, " %10.1f MB/s", result.bytesPerSecond() / 1e6);
+  }
+  p.println(line);
+}
+
+bool BenchRunner::writeJson(const char* path, const BenchResult* results, size_t count, const Options& options) {
+  bool toStdout = strcmp(path, "-") == 0;
+  FILE* file = toStdout ? stdout : fopen(path, "w");
+  if (file == nullptr) return false;
+  FilePrint out(file);
+  JsonWriter json(out);
+  json.beginObject()
+    .key("context").beginObject()
+      .member("samples", (unsigned long)options.samples)
+      .member("min_sample_ms", (unsigned long)options.minSampleMs)
+      .member("warmup_ms", (unsigned long)options.warmupMs)
+      .member("cycle_clock_hz", (unsigned long)CycleClock::frequency())
+    .endObject()
+    .key("benchmarks").beginArray();
+  for (size_t i = 0; i < count; i++) {
+    const BenchResult& r = results[i];
+    json.beginObject()
+      .member("name", (const char*)r.name)
+      .member("iterations", (unsigned long)r.iterations)
+      .member("samples", (unsigned long)r.samples)
+      .member("median_ns", r.medianNs)
+      .member("mean_ns", r.meanNs)
+      .member("min_ns", r.minNs)
+      .member("max_ns", r.maxNs)
+      .member("stddev_ns", r.stddevNs)
+      .member("bytes_per_iteration", (unsigned long)r.bytesPerIteration)
+      .member("bytes_per_second", r.bytesPerSecond())
+      .endObject();
+  }
+  json.endArray().endObject();
+  out.println();
+  bool ok = json.isComplete();
+  if (toStdout) fflush(file);
+  else ok = fclose(file) == 0 && ok;
+  return ok;
+}
+
+struct BaselineEntry {
+  char name[96];
+  double medianNs;
+};
+
+static char* readFile(const char* path, size_t& size) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) return nullptr;
+  fseek(file, 0, SEEK_END);
+  long length = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  char* data = length >= 0 ? (char*)malloc((size_t)length + 1) : nullptr;
+  if (data != nullptr) {
+    size = fread(data, 1, (size_t)length, file);
+    data[size] = '\0';
+  }
+  fclose(file);
+  return data;
+}
+
+// Collects (name, median_ns) from every object that has both
+static size_t readBaseline(const char* json, size_t length, BaselineEntry* entries, size_t maxEntries) {
+  JsonParser parser(json, length);
+  size_t count = 0;
+  char name[sizeof(entries[0].name)] = "";
+  double median = -1;
+  JsonToken t;
+  while ((t = parser.next()) != JsonToken::End && t != JsonToken::Error) {
+    if (t == JsonToken::BeginObject) {
+      name[0] = '\0';
+      median = -1;
+    }
+    else if (t == JsonToken::Key && parser.text() == "name") {
+      if (parser.next() != JsonToken::String) continue;
+      int n = parser.unescape(name, sizeof(name) - 1);
+      name[n < 0 ? 0 : n] = '\0';
+    }
+    else if (t == JsonToken::Key && parser.text() == "median_ns") {
+      if (parser.next() == JsonToken::Number) parser.toDouble(median);
+    }
+    else if (t == JsonToken::EndObject && name[0] != '\0' && median >= 0 && count < maxEntries) {
+      memcpy(entries[count].name, name, sizeof(name));
+      entries[count].medianNs = median;
+      count++;
+      name[0] = '\0';
+    }
+  }
+  return t == JsonToken::End ? count : 0;
+}
+
+int BenchRunner::compareBaseline(const char* path, const BenchResult* results, size_t count, double threshold) {
+  static BaselineEntry entries[kMaxResults];
+  size_t size = 0;
+  char* json = readFile(path, size);
+  if (json == nullptr) {
+    fprintf(stderr, "cannot read baseline %s\n", path);
+    return 2;
+  }
+  size_t entryCount = readBaseline(json, size, entries, kMaxResults);
+  free(json);
+  if (entryCount == 0) {
+    fprintf(stderr, "no results in baseline %s\n", path);
+    return 2;
+  }
+
+  printf("\n%-44s %12s %12s %9s\n", "compared to baseline", "baseline ns", "current ns", "change");
+  int regressions = 0;
+  for (size_t i = 0; i < count; i++) {
+    const BaselineEntry* base = nullptr;
+    for (size_t j = 0; j < entryCount && base == nullptr; j++) {
+      if (strcmp(entries[j].name, results[i].name) == 0) base = &entries[j];
+    }
+    if (base == nullptr) {
+      printf("%-44s %12s %12.2f %9s\n", results[i].name, "-", results[i].medianNs, "new");
+      continue;
+    }
+    double change = base->medianNs > 0 ? 100.0 * (results[i].medianNs - base->medianNs) / base->medianNs : 0;
+    bool regressed = change > threshold;
+    if (regressed) regressions++;
+    printf("%-44s %12.2f %12.2f %+8.1f%%%s\n", results[i].name, base->medianNs, results[i].medianNs, change,
+      regressed ? "  REGRESSION" : "");
+  }
+  if (regressions) printf("%d regression(s) over %.1f%%\n", regressions, threshold);
+  return regressions ? 1 : 0;
+}
+
+int BenchRunner::run(const Options& options) {
+  static BenchResult results[kMaxResults];
+  size_t count = 0;
+  FilePrint console(options.jsonPath != nullptr && strcmp(options.jsonPath, "-") == 0 ? stderr : stdout);
+
+  if (!options.list) {
+    char header[200];
+    snprintf(header, sizeof(header), "%-44s %15s %12s %12s %8s", "benchmark", "median", "min", "max", "stddev");
+    console.println(header);
+  }
+  for (BenchCase* c = BenchCase::first(); c != nullptr; c = c->next()) {
+    size_t runs = c->argCount() ? c->argCount() : 1;
+    for (size_t i = 0; i < runs && count < kMaxResults; i++) {
+      uint64_t arg = c->argCount() ? c->arg(i) : 0;
+      BenchResult& result = results[count];
+      if (arg) snprintf(result.name, sizeof(result.name), "%s/%llu", c->name(), (unsigned long long)arg);
+      else snprintf(result.name, sizeof(result.name), "%s", c->name());
+      if (options.filter != nullptr && strstr(result.name, options.filter) == nullptr) continue;
+      if (options.list) {
+        console.println(result.name);
+        continue;
+      }
+      runCase(c->function(), arg, options, result);
+      printResult(console, result);
+      console.flush();
+      count++;
+    }
+  }
+  if (options.list) return 0;
+
+  if (options.jsonPath != nullptr && !writeJson(options.jsonPath, results, count, options)) {
+    fprintf(stderr, "cannot write %s\n", options.jsonPath);
+    return 2;
+  }
+  if (options.baselinePath != nullptr) return compareBaseline(options.baselinePath, results, count, options.threshold);
+  return 0;
+}
+
+static void printUsage(const char* program) {
+  printf("usage: %s [options]\n"
+    "  --filter TEXT     run only benchmarks whose name contains TEXT\n"
+    "  --list            list the benchmark names and exit\n"
+    "  --json FILE       write the results as JSON to FILE, - for stdout\n"
+    "  --baseline FILE   compare medians with an earlier --json FILE; exit 1 on regressions\n"
+    "  --threshold PCT   slowdown that counts as a regression (default 10)\n"
+    "  --samples N       timed samples per benchmark (default 10, at most %u)\n"
+    "  --min-time MS     minimum length of one sample (default 20)\n"
+    "  --warmup MS       warmup time per benchmark (default 50)\n",
+    program, (unsigned)BenchRunner::kMaxSamples);
+}
+
+int BenchRunner::main(int argc, char** argv) {
+  Options options;
+  for (int i = 1; i < argc; i++) {
+    const char* option = argv[i];
+    const char* value = i + 1 < argc ? argv[i + 1] : nullptr;
+    bool needsValue = true;
+    if (strcmp(option, "--filter") == 0 && value) options.filter = value;
+    else if (strcmp(option, "--json") == 0 && value) options.jsonPath = value;
+    else if (strcmp(option, "--baseline") == 0 && value) options.baselinePath = value;
+    else if (strcmp(option, "--threshold") == 0 && value) options.threshold = atof(value);
+    else if (strcmp(option, "--samples") == 0 && value) options.samples = (uint32_t)atoi(value);
+    else if (strcmp(option, "--min-time") == 0 && value) options.minSampleMs = (uint32_t)atoi(value);
+    else if (strcmp(option, "--warmup") == 0 && value) options.warmupMs = (uint32_t)atoi(value);
+    else if (strcmp(option, "--list") == 0) {
+      options.list = true;
+      needsValue = false;
+    }
+    else {
+      printUsage(argv[0]);
+      return strcmp(option, "--help") == 0 ? 0 : 2;
+    }
+    if (needsValue) i++;
+  }
+
+  CycleClock::begin();
+  if (!CycleClock::isCalibrated()) CycleClock::calibrate();
+  return run(options);
+}
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "RTCorePlatform.h"
+
+/**
+  * @brief The state handed to a benchmark function for one sample.
+  *
+  *  The function runs its operation iterations() times.  Set up done
+  *  inside the function before startTiming() is not measured, nor is tear
+  *  down after stopTiming().
+  *
+  * @code
+  * static void stringLength(BenchState& state) {
+  *   ... build a string of state.arg() characters ...
+  *   state.startTiming();
+  *   for (uint64_t i = 0; i < state.iterations(); i++) doNotOptimize(StringRef(text).length());
+  *   state.setBytesProcessed(state.arg());
+  * }
+  * RT_BENCH("StringRef.length", stringLength, 16, 256, 4096);
+  * @endcode
+  */
+class BenchState
+{
+public:
+  BenchState(uint64_t iterations, uint64_t arg) :
+    iterations_(iterations), arg_(arg), start_(0), stop_(0), bytes_(0) {};
+
+  uint64_t iterations() const { return iterations_; }
+
+  /**
+    * @brief The size argument of this run, 0 for benchmarks without one
+    */
+  uint64_t arg() const { return arg_; }
+
+  // Real time, so benchmarks may install a SimulatedClock
+  void startTiming() { start_ = realNanos(); }
+  void stopTiming() { stop_ = realNanos(); }
+
+  /**
+    * @brief Bytes handled per iteration, for a throughput figure
+    */
+  void setBytesProcessed(uint64_t bytesPerIteration) { bytes_ = bytesPerIteration; }
+  uint64_t bytesProcessed() const { return bytes_; }
+
+protected:
+  friend class BenchRunner;
+
+  uint64_t iterations_;
+  uint64_t arg_;
+  uint64_t start_;
+  uint64_t stop_;
+  uint64_t bytes_;
+};
+
+typedef void (*BenchFunction)(BenchState& state);
+
+/**
+  * @brief A registered benchmark; created by RT_BENCH at static
+  *        initialization and linked into a list, like ProfileSite
+  */
+class BenchCase
+{
+public:
+  static constexpr size_t kMaxArgs = 8;
+
+  BenchCase(const char* name, BenchFunction fn);
+  BenchCase(const char* name, BenchFunction fn, uint64_t arg0, uint64_t arg1 = 0, uint64_t arg2 = 0,
+    uint64_t arg3 = 0, uint64_t arg4 = 0, uint64_t arg5 = 0, uint64_t arg6 = 0, uint64_t arg7 = 0);
+
+  const char* name() const { return name_; }
+  BenchFunction function() const { return fn_; }
+  size_t argCount() const { return argCount_; }
+  uint64_t arg(size_t i) const { return args_[i]; }
+  BenchCase* next() const { return next_; }
+
+  static BenchCase* first() { return head_; }
+
+protected:
+  const char* name_;
+  BenchFunction fn_;
+  uint64_t args_[kMaxArgs];
+  size_t argCount_;
+  BenchCase* next_;
+
+  static BenchCase* head_;
+  static BenchCase* tail_;
+
+  void link();
+};
+
+#define RT_BENCH_CONCAT_(a, b) a##b
+#define RT_BENCH_CONCAT(a, b) RT_BENCH_CONCAT_(a, b)
+
+/**
+  * @brief Registers fn under name, run once per size argument given (up to
+  *        eight, all non-zero) or once without one
+  */
+#define RT_BENCH(name, ...) static BenchCase RT_BENCH_CONCAT(benchCase_, __LINE__)(name, __VA_ARGS__)
+
+/**
+  * @brief Keeps the compiler from discarding a value that is computed only
+  *        to be measured
+  */
+template<typename T>
+inline void doNotOptimize(const T& value) {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : "r,m"(value) : "memory");
+#else
+  static volatile const void* sink;
+  sink = &value;
+#endif
+}
+
+/**
+  * @brief Makes the compiler assume all memory was read and written
+  */
+inline void clobberMemory() {
+#if defined(__GNUC__) || defined(__clang__)
+  asm volatile("" : : : "memory");
+#endif
+}
+
+/**
+  * @brief A Print that discards everything and counts the bytes
+  */
+class NullPrint : public Print
+{
+public:
+  NullPrint() : count_(0) {};
+
+  size_t write(uint8_t) override {
+    count_++;
+    return 1;
+  }
+
+  size_t write(const uint8_t*, size_t size) override {
+    count_ += size;
+    return size;
+  }
+
+  size_t count() const { return count_; }
+  void reset() { count_ = 0; }
+
+protected:
+  size_t count_;
+};
+
+/**
+  * @brief A Print into a fixed buffer, reset between iterations
+  */
+template<size_t SIZE>
+class BufferPrint : public Print
+{
+public:
+  BufferPrint() : size_(0) {};
+
+  size_t write(uint8_t c) override {
+    if (size_ == SIZE) return 0;
+    buffer_[size_++] = c;
+    return 1;
+  }
+
+  size_t write(const uint8_t* data, size_t size) override {
+    if (size > SIZE - size_) size = SIZE - size_;
+    memcpy(buffer_ + size_, data, size);
+    size_ += size;
+    return size;
+  }
+
+  const uint8_t* data() const { return buffer_; }
+  size_t size() const { return size_; }
+  void reset() { size_ = 0; }
+
+protected:
+  uint8_t buffer_[SIZE];
+  size_t size_;
+};
+
+/**
+  * @brief Summary of one benchmark run, times in nanoseconds per iteration
+  */
+struct BenchResult {
+  char name[96];
+  uint64_t iterations;     //!< Per sample
+  uint32_t samples;
+  double minNs;
+  double medianNs;
+  double meanNs;
+  double maxNs;
+  double stddevNs;
+  uint64_t bytesPerIteration;
+
+  double bytesPerSecond() const { return medianNs > 0 ? bytesPerIteration * 1e9 / medianNs : 0; }
+};
+
+/**
+  * @brief Calibrates, warms up and repeats every registered benchmark, and
+  *        reports, saves or compares the results
+  */
+class BenchRunner
+{
+public:
+  static constexpr uint32_t kMaxSamples = 100;
+  static constexpr size_t kMaxResults = 512;
+
+  struct Options {
+    const char* filter = nullptr;   //!< Run only names containing this
+    const char* jsonPath = nullptr; //!< Write results as JSON here, "-" for stdout
+    const char* baselinePath = nullptr;
+    double threshold = 10.0;        //!< Percent slower than the baseline median that fails
+    uint32_t samples = 10;
+    uint32_t minSampleMs = 20;      //!< Iterations are chosen to make a sample last at least this
+    uint32_t warmupMs = 50;
+    bool list = false;
+  };
+
+  /**
+    * @brief Parses the command line and runs; the return value is the
+    *        process exit code
+    */
+  static int main(int argc, char** argv);
+
+  static int run(const Options& options);
+
+  static void runCase(BenchFunction fn, uint64_t arg, const Options& options, BenchResult& result);
+
+protected:
+  static uint64_t sample(BenchFunction fn, uint64_t arg, uint64_t iterations, uint64_t& bytes);
+  static void printResult(Print& p, const BenchResult& result);
+  static bool writeJson(const char* path, const BenchResult* results, size_t count, const Options& options);
+  static int compareBaseline(const char* path, const BenchResult* results, size_t count, double threshold);
+};
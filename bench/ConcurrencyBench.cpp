@@ -0,0 +1,102 @@
+#include "Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+// PublishedString under contention.  Every text the writer publishes
+// describes itself (its version in hex, then a fill character and a length
+// derived from it), so each reader checks each snapshot it gets and a torn
+// read aborts the run.  The argument is the number of reader threads
+// besides the measured one; run with a long --min-time to use these as a
+// stress test.
+
+static constexpr size_t kPublishedLength = 48;
+static constexpr size_t kHeaderLength = 8;
+
+static size_t makeStatus(char* text, uint32_t version) {
+  static const char kHex[] = "0123456789abcdef";
+  for (size_t i = 0; i < kHeaderLength; i++) text[i] = kHex[(version >> (28 - 4 * i)) & 0xf];
+  size_t length = kHeaderLength + version % (kPublishedLength - kHeaderLength + 1);
+  memset(text + kHeaderLength, 'a' + version % 26, length - kHeaderLength);
+  return length;
+}
+
+static void checkStatus(const char* text, size_t length) {
+  if (length == 0) return;
+  char expected[kPublishedLength + 1];
+  char header[kHeaderLength + 1];
+  memcpy(header, text, kHeaderLength);
+  header[kHeaderLength] = '\0';
+  uint32_t version = (uint32_t)strtoul(header, nullptr, 16);
+  size_t expectedLength = makeStatus(expected, version);
+  if (length != expectedLength || memcmp(text, expected, length) != 0) {
+    fprintf(stderr, "PublishedString: torn read of version %lu: %.*s\n",
+      (unsigned long)version, (int)length, text);
+    abort();
+  }
+}
+
+// Background readers that check every snapshot while they run
+class StatusReaders
+{
+public:
+  StatusReaders(const PublishedString<kPublishedLength>& status, size_t count) : stop_(false) {
+    for (size_t i = 0; i < count; i++) {
+      threads_.emplace_back([this, &status]() {
+        char text[kPublishedLength + 1];
+        while (!stop_.load(std::memory_order_relaxed)) {
+          checkStatus(text, status.read(text, sizeof(text)));
+        }
+      });
+    }
+  }
+
+  ~StatusReaders() {
+    stop_.store(true, std::memory_order_relaxed);
+    for (std::thread& t : threads_) t.join();
+  }
+
+protected:
+  std::atomic<bool> stop_;
+  std::vector<std::thread> threads_;
+};
+
+static void publishedStringPublish(BenchState& state) {
+  static PublishedString<kPublishedLength> status;
+  char text[kPublishedLength + 1];
+  uint32_t version = status.version();
+  StatusReaders readers(status, (size_t)state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    size_t length = makeStatus(text, ++version);
+    status.publish(StringSpan(text, length));
+  }
+  state.stopTiming();
+}
+RT_BENCH("PublishedString.publish", publishedStringPublish, 1, 4, 8);
+
+static void publishedStringRead(BenchState& state) {
+  static PublishedString<kPublishedLength> status;
+  std::atomic<bool> stop(false);
+  std::thread writer([&]() {
+    char text[kPublishedLength + 1];
+    uint32_t version = status.version();
+    while (!stop.load(std::memory_order_relaxed)) {
+      size_t length = makeStatus(text, ++version);
+      status.publish(StringSpan(text, length));
+    }
+  });
+  StatusReaders readers(status, (size_t)state.arg());
+  StaticString<kPublishedLength + 1> snapshot;
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    size_t length = status.read(snapshot);
+    checkStatus(snapshot.c_str(), length);
+  }
+  state.stopTiming();
+  stop.store(true, std::memory_order_relaxed);
+  writer.join();
+}
+RT_BENCH("PublishedString.read", publishedStringRead, 1, 4, 8);
@@ -0,0 +1,137 @@
+#include "Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// CoScheduler task switches.  Built as C++20 when the compiler supports
+// coroutines (see CMakeLists.txt); elsewhere CoScheduler.h is empty and so
+// is this file.
+
+#if RT_HAS_COROUTINES
+
+// Advanced by hand, one tick per scheduler pass, so every sleeping task
+// wakes on each pass
+struct BenchTickClock {
+  typedef uint32_t rep;
+  static rep ticks;
+  static rep now() { return ticks; }
+};
+BenchTickClock::rep BenchTickClock::ticks = 0;
+
+static bool coroutineBenchRunning = false;
+
+static CoTask sleepLoop(uint64_t& resumed) {
+  while (coroutineBenchRunning) {
+    co_await sleepFor(1);
+    resumed++;
+  }
+}
+
+// One switch is a wheel timer firing, the task resumed, and its next
+// sleepFor() re-arming the timer and suspending.  The argument is the
+// number of tasks sleeping on the wheel at once, up to kMaxSwitchTasks.
+static constexpr size_t kMaxSwitchTasks = 4096;
+
+static void coSchedulerSwitch(BenchState& state) {
+  static StaticFramePool<256, kMaxSwitchTasks> pool;
+  CoScheduler<BenchTickClock> scheduler(&pool);
+  uint64_t tasks = state.arg();
+  uint64_t resumed = 0;
+  coroutineBenchRunning = true;
+  for (uint64_t i = 0; i < tasks; i++) {
+    if (!scheduler.spawn(sleepLoop(resumed))) {
+      fprintf(stderr, "CoScheduler: frame pool exhausted at task %lu\n", (unsigned long)i);
+      abort();
+    }
+  }
+  // First pass runs each task up to its first sleep
+  scheduler.runOnce();
+  uint64_t passes = (state.iterations() + tasks - 1) / tasks;
+  state.startTiming();
+  for (uint64_t i = 0; i < passes; i++) {
+    BenchTickClock::ticks++;
+    scheduler.runOnce();
+  }
+  state.stopTiming();
+  coroutineBenchRunning = false;
+  while (scheduler.taskCount() > 0) {
+    BenchTickClock::ticks++;
+    scheduler.runOnce();
+  }
+  if (resumed != (passes + 1) * tasks) {
+    fprintf(stderr, "CoScheduler: %lu resumptions, expected %lu\n",
+      (unsigned long)resumed, (unsigned long)((passes + 1) * tasks));
+    abort();
+  }
+}
+RT_BENCH("CoScheduler.switch", coSchedulerSwitch, 1, 16, 256, kMaxSwitchTasks);
+
+static CoTask sleepThenCount(uint32_t ticks, uint64_t& finished) {
+  co_await sleepFor(ticks);
+  finished++;
+}
+
+static CoTask timeoutLoop(uint64_t& finished, uint64_t& timedOut) {
+  while (coroutineBenchRunning) {
+    // Alternately finishes in time and is cancelled.  Kept out of the if
+    // condition, where GCC 12 miscompiles a co_await
+    uint32_t ticks = (finished + timedOut) % 2 == 0 ? 1 : 3;
+    bool inTime = co_await timeout(sleepThenCount(ticks, finished), 2);
+    if (!inTime) timedOut++;
+  }
+}
+
+static CoTask timeoutWithoutFrame(int& result) {
+  uint64_t finished = 0;
+  // The pool's only frame is this task's, so the child gets none
+  bool inTime = co_await timeout(sleepThenCount(1, finished), 2);
+  result = inTime || finished != 0 ? 1 : 0;
+}
+
+// A timeout() around a task whose frame could not be allocated must
+// report failure, not a task that finished in time
+static void checkTimeoutWithoutFrame() {
+  static StaticFramePool<256, 1> pool;
+  CoScheduler<BenchTickClock> scheduler(&pool);
+  int result = -1;
+  scheduler.spawn(timeoutWithoutFrame(result));
+  while (scheduler.taskCount() > 0) {
+    BenchTickClock::ticks++;
+    scheduler.runOnce();
+  }
+  if (result != 0) {
+    fprintf(stderr, "CoScheduler: timeout() of a task without a frame reported %s\n",
+      result < 0 ? "nothing" : "success");
+    abort();
+  }
+}
+
+// Spawning a child under a timeout, then either finishing it or cancelling
+// it when the time runs out
+static void coSchedulerTimeout(BenchState& state) {
+  checkTimeoutWithoutFrame();
+  static StaticFramePool<256, 4> pool;
+  CoScheduler<BenchTickClock> scheduler(&pool);
+  uint64_t finished = 0;
+  uint64_t timedOut = 0;
+  coroutineBenchRunning = true;
+  scheduler.spawn(timeoutLoop(finished, timedOut));
+  state.startTiming();
+  while (finished + timedOut < state.iterations()) {
+    BenchTickClock::ticks++;
+    scheduler.runOnce();
+  }
+  state.stopTiming();
+  coroutineBenchRunning = false;
+  while (scheduler.taskCount() > 0) {
+    BenchTickClock::ticks++;
+    scheduler.runOnce();
+  }
+  if (finished == 0 || finished + 1 < timedOut || timedOut + 1 < finished || pool.available() != 4) {
+    fprintf(stderr, "CoScheduler: %lu finished, %lu timed out, %lu frames free\n",
+      (unsigned long)finished, (unsigned long)timedOut, (unsigned long)pool.available());
+    abort();
+  }
+}
+RT_BENCH("CoScheduler.timeout", coSchedulerTimeout);
+
+#endif
@@ -0,0 +1,41 @@
+#include "Bench.h"
+
+static void histogramRecord(BenchState& state) {
+  static StaticLatencyHistogram<3, 40> histogram;
+  histogram.reset();
+  uint64_t value = 1;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    value = value * 6364136223846793005ull + 1442695040888963407ull;
+    histogram.record(value >> 44);
+  }
+}
+RT_BENCH("LatencyHistogram.record", histogramRecord);
+
+static void histogramPercentile(BenchState& state) {
+  static StaticLatencyHistogram<3, 40> histogram;
+  histogram.reset();
+  for (uint64_t v = 1; v < 100000; v += 7) histogram.record(v);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) doNotOptimize(histogram.percentile(99.0));
+}
+RT_BENCH("LatencyHistogram.percentile", histogramPercentile);
+
+static void profileScope(BenchState& state) {
+  static ProfileSite site("bench", __FILE__, __LINE__);
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    ProfileScope scope(site);
+    clobberMemory();
+  }
+}
+RT_BENCH("ProfileScope", profileScope);
+
+static void watchdogCycle(BenchState& state) {
+  LoopWatchdog watchdog(1000000000u);
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    watchdog.beginCycle();
+    watchdog.checkpoint("a");
+    watchdog.checkpoint("b");
+    watchdog.endCycle("c");
+  }
+}
+RT_BENCH("LoopWatchdog.cycle", watchdogCycle);
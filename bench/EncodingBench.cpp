@@ -0,0 +1,230 @@
+#include "Bench.h"
+#include <stdio.h>
+#include <stdlib.h>
+
+// Log-like text: repetitive structure with changing numbers, roughly what
+// CompressingPrint sees in practice
+static size_t makeLogText(uint8_t* out, size_t size) {
+  static const char* const kLevels[] = { "INFO", "WARN", "DEBUG" };
+  size_t n = 0;
+  uint32_t line = 0;
+  while (n < size) {
+    char text[96];
+    int length = snprintf(text, sizeof(text), "%08lu %s channel=%u gain=%d.%02u state=running\n",
+      (unsigned long)(line * 137u), kLevels[line % 3], line % 16, -(int)(line % 40), (line * 7u) % 100);
+    for (int i = 0; i < length && n < size; i++) out[n++] = (uint8_t)text[i];
+    line++;
+  }
+  return n;
+}
+
+static constexpr size_t kMaxBlock = LZBlock::kMaxBlockSize;
+static constexpr uint8_t kHashLog = 12;
+
+static void lzCompress(BenchState& state) {
+  static uint8_t input[kMaxBlock];
+  static uint8_t output[kMaxBlock + kMaxBlock / 255 + 16];
+  static uint16_t table[1u << kHashLog];
+  size_t size = makeLogText(input, (size_t)state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    memset(table, 0, sizeof(table));
+    doNotOptimize(LZBlock::compress(input, size, output, sizeof(output), table, kHashLog));
+  }
+  state.setBytesProcessed(size);
+}
+RT_BENCH("LZBlock.compress", lzCompress, 1024, 16384, 65535);
+
+static void lzDecompress(BenchState& state) {
+  static uint8_t input[kMaxBlock];
+  static uint8_t compressed[kMaxBlock + kMaxBlock / 255 + 16];
+  static uint8_t output[kMaxBlock];
+  static uint16_t table[1u << kHashLog];
+  size_t size = makeLogText(input, (size_t)state.arg());
+  memset(table, 0, sizeof(table));
+  size_t packed = LZBlock::compress(input, size, compressed, sizeof(compressed), table, kHashLog);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(LZBlock::decompress(compressed, packed, output, sizeof(output)));
+    clobberMemory();
+  }
+  state.setBytesProcessed(size);
+}
+RT_BENCH("LZBlock.decompress", lzDecompress, 1024, 16384, 65535);
+
+static void compressingPrint(BenchState& state) {
+  static uint8_t input[kMaxBlock];
+  static NullPrint sink;
+  static StaticCompressingPrint<4096, 10> packer(sink);
+  size_t size = makeLogText(input, (size_t)state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) packer.write(input, size);
+  packer.flush();
+  state.setBytesProcessed(size);
+}
+RT_BENCH("CompressingPrint.write", compressingPrint, 1024, 16384);
+
+// The uncompressed path for comparison: the same text copied into a buffer
+// as a plain Print would take it
+static void uncompressedPrint(BenchState& state) {
+  static uint8_t input[kMaxBlock];
+  static BufferPrint<16384> sink;
+  size_t size = makeLogText(input, (size_t)state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    sink.reset();
+    sink.write(input, size);
+    clobberMemory();
+  }
+  state.setBytesProcessed(size);
+}
+RT_BENCH("CompressingPrint.write.uncompressed", uncompressedPrint, 1024, 16384);
+
+// Binary against text serialization of the same record; bytes per
+// iteration is the encoded size
+
+struct BenchRecord {
+  uint32_t id;
+  uint64_t timestampUs;
+  double gain;
+  bool muted;
+  const char* name;
+  int32_t samples[8];
+};
+
+static const BenchRecord kRecord = {
+  4711, 1712345678901234ull, -12.5, false, "input/guitar",
+  { 0, 120, -340, 5600, -7800, 9100, -32768, 32767 }
+};
+
+static size_t writeBinary(BinaryWriter& w, const BenchRecord& r) {
+  size_t n = w.writeVarint(r.id);
+  n += w.writeVarint(r.timestampUs);
+  n += w.writeDouble(r.gain);
+  n += w.writeBool(r.muted);
+  n += w.writeString(r.name);
+  n += w.writeVarint(8u);
+  for (int i = 0; i < 8; i++) n += w.writeSigned(r.samples[i]);
+  return n;
+}
+
+static void writeJsonRecord(JsonWriter& json, const BenchRecord& r) {
+  json.beginObject()
+    .member("id", (unsigned long)r.id)
+    .member("timestamp_us", (unsigned long)r.timestampUs)
+    .member("gain", r.gain)
+    .member("muted", r.muted)
+    .member("name", r.name)
+    .key("samples").beginArray();
+  for (int i = 0; i < 8; i++) json.value((long)r.samples[i]);
+  json.endArray().endObject();
+}
+
+static void serializeBinary(BenchState& state) {
+  BufferPrint<256> out;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    out.reset();
+    BinaryWriter w(out);
+    writeBinary(w, kRecord);
+    clobberMemory();
+  }
+  state.setBytesProcessed(out.size());
+}
+RT_BENCH("Serialize.binary", serializeBinary);
+
+static void serializeJson(BenchState& state) {
+  BufferPrint<256> out;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    out.reset();
+    JsonWriter json(out);
+    writeJsonRecord(json, kRecord);
+    clobberMemory();
+  }
+  state.setBytesProcessed(out.size());
+}
+RT_BENCH("Serialize.json", serializeJson);
+
+static void parseBinary(BenchState& state) {
+  BufferPrint<256> out;
+  BinaryWriter w(out);
+  writeBinary(w, kRecord);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    BinaryReader r(out.data(), out.size());
+    BenchRecord record;
+    StringSpan name;
+    uint32_t sampleCount = 0;
+    r.readVarint(record.id);
+    r.readVarint(record.timestampUs);
+    r.readDouble(record.gain);
+    r.readBool(record.muted);
+    r.readString(name);
+    r.readVarint(sampleCount);
+    for (uint32_t s = 0; s < sampleCount && s < 8; s++) r.readSigned(record.samples[s]);
+    doNotOptimize(record);
+    doNotOptimize(name);
+  }
+  state.setBytesProcessed(out.size());
+}
+RT_BENCH("Parse.binary", parseBinary);
+
+static void parseJson(BenchState& state) {
+  BufferPrint<256> out;
+  JsonWriter json(out);
+  writeJsonRecord(json, kRecord);
+  const char* text = (const char*)out.data();
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    JsonParser parser(text, out.size());
+    long number = 0;
+    double real = 0;
+    JsonToken t;
+    while ((t = parser.next()) != JsonToken::End && t != JsonToken::Error) {
+      if (t == JsonToken::Number) {
+        if (!parser.toLong(number)) parser.toDouble(real);
+      }
+    }
+    doNotOptimize(number);
+    doNotOptimize(real);
+  }
+  state.setBytesProcessed(out.size());
+}
+RT_BENCH("Parse.json", parseJson);
+
+// Numbers longer than the digits toDouble() passes on to strtod, as some
+// encoders print doubles.  The results are checked against strtod on the
+// whole text before timing.
+static const char* const kLongNumbers[] = {
+  "3.14159265358979323846264338327950288419716939937510582097494459230781640628620899",
+  "-0.00000000000000000000000000000000000000000000000000000000000000000000000012345678901234567890123e-3",
+  "1234567890123456789012345678901234567890123456789012345678901234567890123456789012345678901e200",
+};
+
+static double parseNumber(const char* text) {
+  JsonParser parser(text, strlen(text));
+  double value = 0;
+  if (parser.next() != JsonToken::Number || !parser.toDouble(value)) {
+    fprintf(stderr, "JsonParser: could not convert %s\n", text);
+    abort();
+  }
+  return value;
+}
+
+static void parseJsonLongNumber(BenchState& state) {
+  size_t bytes = 0;
+  for (const char* text : kLongNumbers) {
+    double expected = strtod(text, nullptr);
+    double value = parseNumber(text);
+    if (memcmp(&value, &expected, sizeof(value)) != 0) {
+      fprintf(stderr, "JsonParser: %s converted to %.17g, expected %.17g\n", text, value, expected);
+      abort();
+    }
+    bytes += strlen(text);
+  }
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    for (const char* text : kLongNumbers) doNotOptimize(parseNumber(text));
+  }
+  state.setBytesProcessed(bytes);
+}
+RT_BENCH("Parse.json.longNumber", parseJsonLongNumber);
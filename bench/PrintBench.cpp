@@ -0,0 +1,63 @@
+#include "Bench.h"
+
+// The largest number with arg() decimal digits, arg() from 1 to 19
+static unsigned long digitsValue(uint64_t digits) {
+  uint64_t v = 9;
+  for (uint64_t i = 1; i < digits; i++) v = v * 10 + 9;
+  return (unsigned long)v;
+}
+
+static void printUnsigned(BenchState& state) {
+  NullPrint out;
+  unsigned long value = digitsValue(state.arg());
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(value);
+    out.print(value);
+  }
+  doNotOptimize(out.count());
+}
+RT_BENCH("Print.print(unsigned long)/digits", printUnsigned, 1, 5, 10);
+
+static void printHex(BenchState& state) {
+  NullPrint out;
+  unsigned long value = 0xdeadbeefUL;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(value);
+    out.print(value, HEX);
+  }
+  doNotOptimize(out.count());
+}
+RT_BENCH("Print.print(unsigned long, HEX)", printHex);
+
+static void printNegative(BenchState& state) {
+  NullPrint out;
+  long value = -1234567L;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(value);
+    out.print(value);
+  }
+  doNotOptimize(out.count());
+}
+RT_BENCH("Print.print(long)", printNegative);
+
+static void printDouble(BenchState& state) {
+  NullPrint out;
+  double value = -1234.56789;
+  int digits = (int)state.arg();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(value);
+    out.print(value, digits);
+  }
+  doNotOptimize(out.count());
+}
+RT_BENCH("Print.print(double)/decimals", printDouble, 2, 6);
+
+static void printlnString(BenchState& state) {
+  NullPrint out;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    out.println("the quick brown fox jumps over the lazy dog");
+    clobberMemory();
+  }
+  doNotOptimize(out.count());
+}
+RT_BENCH("Print.println(str)", printlnString);
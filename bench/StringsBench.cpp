@@ -0,0 +1,170 @@
+#include "Bench.h"
+
+static constexpr size_t kMaxText = 4096;
+
+// length characters of lower case text ending in "needle", NUL terminated
+static void makeText(char* text, size_t length) {
+  static const char kTail[] = "needle";
+  for (size_t i = 0; i < length; i++) text[i] = (char)('a' + (i * 7) % 26);
+  size_t tail = sizeof(kTail) - 1;
+  if (length >= tail) memcpy(text + length - tail, kTail, tail);
+  text[length] = '\0';
+}
+
+static void stringLength(BenchState& state) {
+  static char text[kMaxText + 1];
+  makeText(text, state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    StringRef s(text);
+    doNotOptimize(s.length());
+    clobberMemory();
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRef.length", stringLength, 16, 256, 4096);
+
+static void indexOfChar(BenchState& state) {
+  static char text[kMaxText + 1];
+  makeText(text, state.arg());
+  StringRef s(text);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(s.indexOf('!'));
+    clobberMemory();
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRef.indexOf(char)", indexOfChar, 16, 256, 4096);
+
+static void indexOfString(BenchState& state) {
+  static char text[kMaxText + 1];
+  makeText(text, state.arg());
+  StringRef s(text);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(s.indexOf("needle"));
+    clobberMemory();
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRef.indexOf(str)", indexOfString, 16, 256, 4096);
+
+static void compareEqual(BenchState& state) {
+  static char a[kMaxText + 1];
+  static char b[kMaxText + 1];
+  makeText(a, state.arg());
+  makeText(b, state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(StringRef::compare(a, b));
+    clobberMemory();
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRef.compare", compareEqual, 16, 256, 4096);
+
+static void equalsIgnoreCase(BenchState& state) {
+  static char a[kMaxText + 1];
+  static char b[kMaxText + 1];
+  makeText(a, state.arg());
+  makeText(b, state.arg());
+  for (size_t i = 0; i < state.arg(); i++) b[i] = (char)(b[i] - 'a' + 'A');
+  StringRef lower(a);
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(lower.equalsIgnoreCase(b));
+    clobberMemory();
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRef.equalsIgnoreCase", equalsIgnoreCase, 16, 256, 4096);
+
+static void appendString(BenchState& state) {
+  static char text[kMaxText + 1];
+  static StaticString<kMaxText + 1> s;
+  makeText(text, state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    s.reset();
+    doNotOptimize(s.append(StringRef(text)));
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("FixedString.append(str)", appendString, 16, 256, 4096);
+
+static void appendInt(BenchState& state) {
+  StaticString<64> s;
+  int value = 1234567;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    s.reset();
+    doNotOptimize(s.append(value));
+    clobberMemory();
+  }
+}
+RT_BENCH("FixedString.append(int)", appendInt);
+
+static void appendPrintf(BenchState& state) {
+  StaticString<128> s;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    s.reset();
+    doNotOptimize(s.printf("%s=%d gain=%.2f", "channel", (int)(i & 0xff), -12.5));
+  }
+}
+RT_BENCH("FixedString.printf", appendPrintf);
+
+static void printIntoFixedString(BenchState& state) {
+  StaticString<128> s;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    s.reset();
+    s.print("channel=");
+    s.print((unsigned long)(i & 0xff));
+    doNotOptimize(s.print(" gain=-12.50"));
+  }
+}
+RT_BENCH("FixedString.print", printIntoFixedString);
+
+static void arenaAllocateString(BenchState& state) {
+  static StaticStringArena<4096> arena;
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    StringArenaScope scope(arena);
+    FixedString s = arena.allocateString(64);
+    doNotOptimize(s.append('x'));
+  }
+}
+RT_BENCH("StringArena.allocateString", arenaAllocateString);
+
+static void smallStringAppendChars(BenchState& state) {
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    SmallString<32> s;
+    for (uint64_t c = 0; c < state.arg(); c++) s.write((uint8_t)('a' + c % 26));
+    doNotOptimize(s.length());
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("SmallString.append(char)", smallStringAppendChars, 16, 256, 4096);
+
+static void ropeWrite(BenchState& state) {
+  static char text[kMaxText + 1];
+  static StaticStringChunkPool<512, 16> pool;
+  makeText(text, state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    StringRope rope(pool);
+    doNotOptimize(rope.write(text, state.arg()));
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("StringRope.write", ropeWrite, 16, 256, 4096);
+
+static void ringStringWrite(BenchState& state) {
+  static char text[kMaxText + 1];
+  static StaticRingString<8192> ring;
+  makeText(text, state.arg());
+  state.startTiming();
+  for (uint64_t i = 0; i < state.iterations(); i++) {
+    doNotOptimize(ring.write(text, state.arg()));
+  }
+  state.setBytesProcessed(state.arg());
+}
+RT_BENCH("RingString.write", ringStringWrite, 16, 256, 4096);
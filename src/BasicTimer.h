@@ -2,26 +2,41 @@
 #define _RT_CORE_PLATFORM_BASIC_TIMER_H_
 
 #include "./RTCorePlatformDeps.h"
+#include "./Time/Clocks.h"
+#include "./Time/CycleClock.h"
+#include "./Time/FrameClock.h"
 
 /**
-  * @brief Class that wraps millis() based timers for easier use.
+  * @brief Class that wraps clock based timers for easier use.
   *
-  *  A BasicTimer makes it easy to perform an action after a certain amount of milliseconds has passed.
+  *  A ClockTimer makes it easy to perform an action after a certain amount of time has passed.
+  *  The clock policy (see Time/Clocks.h) decides the time unit and counter width; all times
+  *  are in the clock's ticks.  Elapsed time is computed by unsigned subtraction in the clock's
+  *  tick type, so expiry stays correct when the counter wraps, as long as the timeout is below
+  *  half the counter range.
+  *
+  * @tparam Clock The clock policy, e.g. MillisClock, MicrosClock, NanosClock
+  * @tparam Duration The type used to store the timeout, the clock's tick type by default.  A
+  *         narrower type saves memory when timeouts are short.
   */
-class BasicTimer
+template<typename Clock, typename Duration = typename Clock::rep>
+class ClockTimer
 {
 public:
+  typedef typename Clock::rep rep;
+  typedef Duration duration;
+
   /**
-    * @brief Construct a new TBasicTimer
+    * @brief Construct a new ClockTimer
     *
-    * @param timeout The timers timeout in milliseconds
+    * @param timeout The timers timeout in clock ticks
     */
-  BasicTimer(unsigned long timeout = 500) : lastReset(0), storedTimeout(timeout) {};
+  ClockTimer(duration timeout = 500) : lastReset(0), storedTimeout(timeout) {};
 
   /**
     * @brief Copy Constructor
     */
-  BasicTimer(const BasicTimer& other) : lastReset(other.lastReset),
+  ClockTimer(const ClockTimer& other) : lastReset(other.lastReset),
     storedTimeout(other.storedTimeout) {};
 
 
@@ -38,7 +53,7 @@ public:
     *  @see reset()
     *  @see setTimeout()
     */
-  void begin(unsigned long timeout) {
+  void begin(duration timeout) {
     setTimeout(timeout);
     reset();
   };
@@ -56,44 +71,43 @@ public:
     */
   bool hasExpired() const
   {
-    auto current = now();
-    if (current - lastReset > storedTimeout) return true;
+    if (elapsedTime() > storedTimeout) return true;
     else return false;
   }
 
   /**
-    * @brief Returns the timer's stored timeout time in milliseconds
+    * @brief Returns the timer's stored timeout time in clock ticks
     *
-    * @return unsigned long
+    * @return duration
     */
-  unsigned long timeout() const { return storedTimeout; };
+  duration timeout() const { return storedTimeout; };
 
   /**
-    * @brief Get the current time in milliseconds
+    * @brief Get the current time in clock ticks
     *
-    * @return unsigned long The current time in milliseconds
+    * @return rep The current time
     */
-  static unsigned long now()
+  static rep now()
   {
-    return millis();
+    return Clock::now();
   }
 
   /**
     * @brief The amount of time that has elapsed since the timer
-    *        was last reset in milliseconds.
+    *        was last reset in clock ticks.
     *
-    * @return unsigned long The elapsed time in milliseconds
+    * @return rep The elapsed time
     */
-  unsigned long elapsedTime() const {
-    return (now() - lastReset);
+  rep elapsedTime() const {
+    return (rep)(now() - lastReset);
   }
 
   /**
     * @brief Set the timer's timeout to the supplied value
     *
-    * @param timeout The new timer period in milliseconds
+    * @param timeout The new timer period in clock ticks
     */
-  void setTimeout(unsigned long timeout) { storedTimeout = timeout; };
+  void setTimeout(duration timeout) { storedTimeout = timeout; };
 
   template<typename Functor>
   void onExpire(Functor cb) {
@@ -135,21 +149,40 @@ public:
   }
 
 protected:
-  unsigned long  lastReset; //!< The last timestamp at which the timer was reset
-  unsigned long storedTimeout;//!< The timeout value in milliseconds
+  rep  lastReset; //!< The last timestamp at which the timer was reset
+  duration storedTimeout;//!< The timeout value in clock ticks
 };
 
+/**
+  * @brief The original millis() based timer, timeouts in milliseconds
+  */
+typedef ClockTimer<MillisClock> BasicTimer;
+typedef ClockTimer<MicrosClock> MicrosTimer; //!< Timeouts in microseconds, up to ~35 minutes
+typedef ClockTimer<Micros64Clock> Micros64Timer; //!< Timeouts in microseconds
+typedef ClockTimer<NanosClock> NanosTimer; //!< Timeouts in nanoseconds
+typedef ClockTimer<CycleClock> CycleTimer; //!< Timeouts in CPU cycles
+typedef ClockTimer<FrameClock<MillisClock>> FrameTimer; //!< Timeouts in milliseconds, against the time of FrameClock<>::tick()
+typedef ClockTimer<FrameClock<MicrosClock>> FrameMicrosTimer; //!< Timeouts in microseconds, against the time of FrameClock<MicrosClock>::tick()
+
 /**
   * @brief Template class for a timer with a static, constant Timeout value.
   *        This reduces the memory footprint of the class if you never want the
   *        timers time to change.
   *
-  * @tparam TIMEOUT The timeout in milliseconds
+  * @tparam TIMEOUT The timeout in clock ticks
+  * @tparam Clock The clock policy, milliseconds by default
   */
-template <unsigned long TIMEOUT>
+template <uint64_t TIMEOUT, typename Clock = MillisClock>
 class StaticTimer
 {
 public:
+  typedef typename Clock::rep rep;
+
+  static_assert(TIMEOUT <= (rep)~(rep)0 / 2,
+    "TIMEOUT must be below half the range of the clock's counter to survive wraparound");
+
+  static constexpr rep kTimeout = (rep)TIMEOUT;
+
   /**
     * @brief Construct a new TStaticTimer object
     *
@@ -170,28 +203,28 @@ public:
     */
   bool hasExpired() const
   {
-    if (elapsedTime() > TIMEOUT) return true;
+    if (elapsedTime() > kTimeout) return true;
     else return false;
   }
 
   /**
-    * @brief Gets the currenet timestamp in milliseconds
+    * @brief Gets the currenet timestamp in clock ticks
     *
-    * @return unsigned long The current timestamp in milliseconds
+    * @return rep The current timestamp
     */
-  unsigned long now() const
+  rep now() const
   {
-    return millis();
+    return Clock::now();
   }
 
   /**
     * @brief The amount of time that has elapsed since the timer
-    *        was last reset in milliseconds.
+    *        was last reset in clock ticks.
     *
-    * @return unsigned long The elapsed time in milliseconds
+    * @return rep The elapsed time
     */
-  unsigned long elapsedTime() const {
-    return (now() - lastReset);
+  rep elapsedTime() const {
+    return (rep)(now() - lastReset);
   }
 
 
@@ -242,7 +275,7 @@ public:
   }
 
 protected:
-  unsigned long  lastReset;
+  rep  lastReset;
 };
 
 #endif // ! _RT_PEDAL_LIB_BASIC_TIMER_H
@@ -0,0 +1,7 @@
+#ifndef _RT_CORE_LIB_DIAGNOSTICS_DEPS_H_
+#define _RT_CORE_LIB_DIAGNOSTICS_DEPS_H_
+
+#include "../RTCorePlatformDeps.h"
+#include "../Time/CycleClock.h"
+
+#endif
@@ -0,0 +1,148 @@
+#include "LatencyHistogram.h"
+#include "../Encoding/BinaryWriter.h"
+#include "../Encoding/BinaryReader.h"
+
+LatencyHistogram::LatencyHistogram(std::atomic<uint32_t>* counts, uint8_t subBucketBits, uint8_t maxExponent, const char* unit) :
+  counts_(counts), bucketCount_(bucketCountFor(subBucketBits, maxExponent)), subBucketBits_(subBucketBits),
+  maxExponent_(maxExponent), unit_(unit) {
+  reset();
+}
+
+void LatencyHistogram::reset() {
+  count_.store(0, std::memory_order_relaxed);
+  total_.store(0, std::memory_order_relaxed);
+  min_.store(~0ull, std::memory_order_relaxed);
+  max_.store(0, std::memory_order_relaxed);
+  for (size_t i = 0; i < bucketCount_; i++) counts_[i].store(0, std::memory_order_relaxed);
+}
+
+uint64_t LatencyHistogram::bucketLowerBound(size_t bucket) const {
+  size_t subBuckets = (size_t)1 << subBucketBits_;
+  if (bucket < subBuckets) return (uint64_t)bucket;
+  int exponent = (int)(bucket >> subBucketBits_) + subBucketBits_ - 1;
+  uint64_t sub = bucket & (subBuckets - 1);
+  return ((uint64_t)subBuckets + sub) << (exponent - subBucketBits_);
+}
+
+uint64_t LatencyHistogram::bucketUpperBound(size_t bucket) const {
+  if (bucket + 1 >= bucketCount_) return ~0ull;
+  return bucketLowerBound(bucket + 1) - 1;
+}
+
+bool LatencyHistogram::merge(const LatencyHistogram& other) {
+  if (!sameLayout(other)) return false;
+  uint64_t otherCount = other.count();
+  if (otherCount == 0) return true;
+  for (size_t i = 0; i < bucketCount_; i++) {
+    uint32_t c = other.countAt(i);
+    if (c) counts_[i].fetch_add(c, std::memory_order_relaxed);
+  }
+  count_.fetch_add(otherCount, std::memory_order_relaxed);
+  total_.fetch_add(other.total(), std::memory_order_relaxed);
+  uint64_t value = other.min();
+  uint64_t seen = min_.load(std::memory_order_relaxed);
+  while (value < seen && !min_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+  value = other.max();
+  seen = max_.load(std::memory_order_relaxed);
+  while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+  return true;
+}
+
+uint64_t LatencyHistogram::percentile(double percent) const {
+  uint64_t total = 0;
+  for (size_t i = 0; i < bucketCount_; i++) total += countAt(i);
+  if (total == 0) return 0;
+  if (percent < 0.0) percent = 0.0;
+  if (percent > 100.0) percent = 100.0;
+  uint64_t target = (uint64_t)(total * percent / 100.0 + 0.5);
+  if (target == 0) target = 1;
+  uint64_t seen = 0;
+  uint64_t maxValue = max();
+  for (size_t i = 0; i < bucketCount_; i++) {
+    seen += countAt(i);
+    if (seen >= target) {
+      uint64_t upper = bucketUpperBound(i);
+      return upper < maxValue ? upper : maxValue;
+    }
+  }
+  return maxValue;
+}
+
+// Print has no 64 bit overloads
+static size_t printValue(Print& p, const char* label, uint64_t value, const char* unit) {
+  char digits[21];
+  int i = sizeof(digits) - 1;
+  digits[i] = '\0';
+  do {
+    digits[--i] = (char)('0' + value % 10);
+    value /= 10;
+  } while (value);
+  size_t n = p.print(label);
+  n += p.print(&digits[i]);
+  n += p.print(unit);
+  return n;
+}
+
+size_t LatencyHistogram::printTo(Print& p) const {
+  size_t n = 0;
+  n += printValue(p, "n=", count(), "");
+  n += printValue(p, " min=", min(), unit_);
+  n += printValue(p, " mean=", mean(), unit_);
+  n += printValue(p, " p50=", percentile(50.0), unit_);
+  n += printValue(p, " p90=", percentile(90.0), unit_);
+  n += printValue(p, " p99=", percentile(99.0), unit_);
+  n += printValue(p, " p99.9=", percentile(99.9), unit_);
+  n += printValue(p, " max=", max(), unit_);
+  return n;
+}
+
+size_t LatencyHistogram::serializeTo(BinaryWriter& w) const {
+  size_t used = 0;
+  for (size_t i = 0; i < bucketCount_; i++) {
+    if (countAt(i)) used++;
+  }
+  size_t n = 0;
+  n += w.writeVarint(subBucketBits_);
+  n += w.writeVarint(maxExponent_);
+  n += w.writeVarint(count());
+  n += w.writeVarint(total());
+  n += w.writeVarint(min());
+  n += w.writeVarint(max());
+  n += w.writeVarint(used);
+  size_t last = 0;
+  for (size_t i = 0; i < bucketCount_; i++) {
+    uint32_t c = countAt(i);
+    if (!c) continue;
+    n += w.writeVarint(i - last);
+    n += w.writeVarint(c);
+    last = i;
+  }
+  return n;
+}
+
+bool LatencyHistogram::deserializeFrom(BinaryReader& r) {
+  uint8_t subBucketBits, maxExponent;
+  uint64_t count, total, minValue, maxValue;
+  size_t used;
+  if (!r.readVarint(subBucketBits) || !r.readVarint(maxExponent)) return false;
+  if (subBucketBits != subBucketBits_ || maxExponent != maxExponent_) return false;
+  if (!r.readVarint(count) || !r.readVarint(total) || !r.readVarint(minValue) ||
+    !r.readVarint(maxValue) || !r.readVarint(used)) return false;
+  if (used > bucketCount_) return false;
+
+  reset();
+  size_t index = 0;
+  for (size_t i = 0; i < used; i++) {
+    size_t gap;
+    uint32_t c;
+    if (!r.readVarint(gap) || !r.readVarint(c)) return false;
+    index += gap;
+    if (index >= bucketCount_) return false;
+    counts_[index].store(c, std::memory_order_relaxed);
+  }
+  count_.store(count, std::memory_order_relaxed);
+  total_.store(total, std::memory_order_relaxed);
+  min_.store(count ? minValue : ~0ull, std::memory_order_relaxed);
+  max_.store(maxValue, std::memory_order_relaxed);
+  return true;
+}
@@ -0,0 +1,174 @@
+#pragma once
+
+#include "./DiagnosticsDeps.h"
+#include "../Encoding/Serializable.h"
+#include <atomic>
+
+/**
+  * @brief HDR style histogram of durations (or any non-negative values) in
+  *        fixed memory.
+  *
+  *  Values are bucketed log-linearly: every power of two is split into
+  *  2^subBucketBits linear sub-buckets, so a value is known to within
+  *  1 / 2^subBucketBits of itself whatever its magnitude.  Values below
+  *  2^subBucketBits are exact; values from 2^(maxExponent + 1) up share the
+  *  last bucket.
+  *
+  *  record() is O(1) and lock free (relaxed atomics), so one histogram can
+  *  be fed from several threads.  For the least contention give each thread
+  *  its own histogram and merge() them when reporting.
+  *
+  *  The bucket counters are supplied by the caller, see
+  *  StaticLatencyHistogram for a histogram that owns them.
+  */
+class LatencyHistogram : public Printable, public Serializable
+{
+public:
+  static constexpr uint32_t kSchemaId = 0x4c48; //!< "LH", see Serializable::schemaId()
+
+  /**
+    * @brief The number of counters a layout needs
+    */
+  static constexpr size_t bucketCountFor(uint8_t subBucketBits, uint8_t maxExponent) {
+    return (size_t)(maxExponent - subBucketBits + 2) << subBucketBits;
+  }
+
+  /**
+    * @param counts bucketCountFor(subBucketBits, maxExponent) counters
+    * @param subBucketBits Precision, 1 to 8 bits
+    * @param maxExponent Largest power of two tracked, at least subBucketBits and at most 62
+    * @param unit Printed after every value, e.g. "ns"
+    */
+  LatencyHistogram(std::atomic<uint32_t>* counts, uint8_t subBucketBits, uint8_t maxExponent, const char* unit = "");
+
+  LatencyHistogram(const LatencyHistogram&) = delete;
+  LatencyHistogram& operator=(const LatencyHistogram&) = delete;
+
+  void record(uint64_t value) {
+    count_.fetch_add(1, std::memory_order_relaxed);
+    total_.fetch_add(value, std::memory_order_relaxed);
+    uint64_t seen = min_.load(std::memory_order_relaxed);
+    while (value < seen && !min_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    seen = max_.load(std::memory_order_relaxed);
+    while (value > seen && !max_.compare_exchange_weak(seen, value, std::memory_order_relaxed)) {}
+    counts_[bucketOf(value)].fetch_add(1, std::memory_order_relaxed);
+  }
+
+  void reset();
+
+  /**
+    * @brief Adds another histogram's counts to this one
+    *
+    * @return false If the two have different layouts
+    */
+  bool merge(const LatencyHistogram& other);
+
+  /**
+    * @brief Replaces this histogram's contents with a copy of source
+    *
+    * @return false If the two have different layouts
+    */
+  bool copyFrom(const LatencyHistogram& source) {
+    if (!sameLayout(source)) return false;
+    reset();
+    return merge(source);
+  }
+
+  uint64_t count() const { return count_.load(std::memory_order_relaxed); }
+  uint64_t total() const { return total_.load(std::memory_order_relaxed); }
+  uint64_t min() const { return count() ? min_.load(std::memory_order_relaxed) : 0; }
+  uint64_t max() const { return max_.load(std::memory_order_relaxed); }
+  uint64_t mean() const { return count() ? total() / count() : 0; }
+
+  /**
+    * @brief The highest value that could be at the given percentile: the
+    *        upper bound of its bucket, clamped to max()
+    *
+    * @param percent 0 to 100, e.g. 99.9
+    */
+  uint64_t percentile(double percent) const;
+
+  size_t bucketCount() const { return bucketCount_; }
+  uint32_t countAt(size_t bucket) const { return counts_[bucket].load(std::memory_order_relaxed); }
+  uint8_t subBucketBits() const { return subBucketBits_; }
+  uint8_t maxExponent() const { return maxExponent_; }
+
+  size_t bucketOf(uint64_t value) const {
+    if (value < ((uint64_t)1 << subBucketBits_)) return (size_t)value;
+    int exponent = 63 - countLeadingZeros(value);
+    if (exponent > maxExponent_) return bucketCount_ - 1;
+    size_t sub = (size_t)(value >> (exponent - subBucketBits_)) & (((size_t)1 << subBucketBits_) - 1);
+    return ((size_t)(exponent - subBucketBits_ + 1) << subBucketBits_) + sub;
+  }
+
+  uint64_t bucketLowerBound(size_t bucket) const;
+  uint64_t bucketUpperBound(size_t bucket) const;
+
+  /**
+    * @brief Prints count, min, mean, p50, p90, p99, p99.9 and max on one line
+    */
+  size_t printTo(Print& p) const override;
+
+  /**
+    * @brief Writes the layout, the summary values and the non-empty buckets
+    *        as (gap, count) varint pairs; an empty histogram takes a few bytes
+    */
+  size_t serializeTo(BinaryWriter& w) const override;
+
+  /**
+    * @brief Replaces the contents with serialized data of the same layout
+    */
+  bool deserializeFrom(BinaryReader& r) override;
+
+  uint32_t schemaId() const override { return kSchemaId; }
+
+protected:
+  std::atomic<uint32_t>* counts_;
+  size_t bucketCount_;
+  uint8_t subBucketBits_;
+  uint8_t maxExponent_;
+  const char* unit_;
+  std::atomic<uint64_t> count_;
+  std::atomic<uint64_t> total_;
+  std::atomic<uint64_t> min_;
+  std::atomic<uint64_t> max_;
+
+  bool sameLayout(const LatencyHistogram& other) const {
+    return other.subBucketBits_ == subBucketBits_ && other.maxExponent_ == maxExponent_;
+  }
+
+  static int countLeadingZeros(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_clzll(v);
+#else
+    int n = 0;
+    while (!(v & 0x8000000000000000ull)) {
+      v <<= 1;
+      n++;
+    }
+    return n;
+#endif
+  }
+};
+
+/**
+  * @brief A LatencyHistogram that owns its counters
+  *
+  * @tparam SUB_BUCKET_BITS Precision; 2 gives 25%, 3 gives 12.5%, 7 gives under 1%
+  * @tparam MAX_EXPONENT Values from 2^(MAX_EXPONENT + 1) up share the last bucket
+  */
+template<uint8_t SUB_BUCKET_BITS = 3, uint8_t MAX_EXPONENT = 40>
+class StaticLatencyHistogram : public LatencyHistogram
+{
+public:
+  static_assert(SUB_BUCKET_BITS >= 1 && SUB_BUCKET_BITS <= 8, "SUB_BUCKET_BITS must be 1 to 8");
+  static_assert(MAX_EXPONENT >= SUB_BUCKET_BITS && MAX_EXPONENT <= 62, "MAX_EXPONENT must be SUB_BUCKET_BITS to 62");
+
+  static constexpr size_t kBuckets = LatencyHistogram::bucketCountFor(SUB_BUCKET_BITS, MAX_EXPONENT);
+
+  StaticLatencyHistogram(const char* unit = "") :
+    LatencyHistogram(buckets_, SUB_BUCKET_BITS, MAX_EXPONENT, unit) {};
+
+protected:
+  std::atomic<uint32_t> buckets_[kBuckets];
+};
@@ -0,0 +1,140 @@
+#include "LoopWatchdog.h"
+
+#if RT_HAS_WATCHDOG_MONITOR
+#include <chrono>
+#endif
+
+static uint64_t nanosToTicks(uint64_t ns) {
+  uint64_t hz = CycleClock::frequency();
+  if (hz == 0) return ns;
+  return ns * (hz / 1000ull) / 1000000ull + ns * (hz % 1000ull) / 1000000000ull;
+}
+
+static uint32_t ticksToNanos32(uint64_t ticks) {
+  uint64_t ns = CycleClock::toNanos(ticks);
+  return ns > 0xffffffffull ? 0xffffffffu : (uint32_t)ns;
+}
+
+LoopWatchdog::LoopWatchdog(uint32_t budgetNs) :
+  cycleStart_(0), phaseStart_(0), slowestTicks_(0), slowestPhase_(nullptr), activeSince_(0) {
+#if RT_HAS_WATCHDOG_MONITOR
+  monitorRunning_.store(false, std::memory_order_relaxed);
+#endif
+  setBudget(budgetNs);
+  reset();
+}
+
+LoopWatchdog::~LoopWatchdog() {
+#if RT_HAS_WATCHDOG_MONITOR
+  stopMonitor();
+#endif
+}
+
+void LoopWatchdog::setBudget(uint32_t budgetNs) {
+  budgetNs_ = budgetNs;
+  budgetTicks_ = nanosToTicks(budgetNs);
+}
+
+void LoopWatchdog::reset() {
+  cycles_.store(0, std::memory_order_relaxed);
+  worstTicks_.store(0, std::memory_order_relaxed);
+  overruns_.store(0, std::memory_order_relaxed);
+  for (int i = 0; i < kRingSize; i++) {
+    ring_[i].sequence.store(0, std::memory_order_relaxed);
+  }
+}
+
+// Each slot is a small seqlock: the sequence is odd while the loop writes the
+// record, so readers never wait and discard copies that raced a write.
+void LoopWatchdog::recordOverrun(uint64_t ticks) {
+  uint32_t index = overruns_.load(std::memory_order_relaxed);
+  Slot& slot = ring_[index & (kRingSize - 1)];
+  uint32_t seq = slot.sequence.load(std::memory_order_relaxed);
+  slot.sequence.store(seq + 1, std::memory_order_relaxed);
+  std::atomic_thread_fence(std::memory_order_release);
+  slot.cycle.store(cycles_.load(std::memory_order_relaxed) - 1, std::memory_order_relaxed);
+  slot.durationNs.store(ticksToNanos32(ticks), std::memory_order_relaxed);
+  slot.budgetNs.store(budgetNs_, std::memory_order_relaxed);
+  slot.slowestPhaseNs.store(ticksToNanos32(slowestTicks_), std::memory_order_relaxed);
+  slot.slowestPhase.store(slowestPhase_, std::memory_order_relaxed);
+  slot.sequence.store(seq + 2, std::memory_order_release);
+  overruns_.store(index + 1, std::memory_order_release);
+}
+
+size_t LoopWatchdog::readOverruns(OverrunRecord* out, size_t maxRecords) const {
+  uint32_t total = overruns_.load(std::memory_order_acquire);
+  size_t available = total < (uint32_t)kRingSize ? total : kRingSize;
+  size_t n = 0;
+  for (size_t i = 0; i < available && n < maxRecords; i++) {
+    const Slot& slot = ring_[(total - 1 - i) & (kRingSize - 1)];
+    uint32_t before = slot.sequence.load(std::memory_order_acquire);
+    if (before & 1) continue;
+    OverrunRecord copy;
+    copy.cycle = slot.cycle.load(std::memory_order_relaxed);
+    copy.durationNs = slot.durationNs.load(std::memory_order_relaxed);
+    copy.budgetNs = slot.budgetNs.load(std::memory_order_relaxed);
+    copy.slowestPhaseNs = slot.slowestPhaseNs.load(std::memory_order_relaxed);
+    copy.slowestPhase = slot.slowestPhase.load(std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.sequence.load(std::memory_order_relaxed) != before) continue;
+    out[n++] = copy;
+  }
+  return n;
+}
+
+size_t LoopWatchdog::printTo(Print& p) const {
+  size_t n = 0;
+  n += p.print("cycles=");
+  n += p.print((unsigned long)cycleCount());
+  n += p.print(" overruns=");
+  n += p.print((unsigned long)overrunCount());
+  n += p.print(" budget=");
+  n += p.print((unsigned long)budgetNs_);
+  n += p.print("ns worst=");
+  n += p.print((unsigned long)worstCycleNs());
+  n += p.println("ns");
+
+  OverrunRecord records[kRingSize];
+  size_t count = readOverruns(records, kRingSize);
+  for (size_t i = 0; i < count; i++) {
+    const OverrunRecord& r = records[i];
+    n += p.print("  cycle ");
+    n += p.print((unsigned long)r.cycle);
+    n += p.print(": ");
+    n += p.print((unsigned long)r.durationNs);
+    n += p.print("ns, slowest ");
+    n += p.print(r.slowestPhase != nullptr ? r.slowestPhase : "?");
+    n += p.print(" ");
+    n += p.print((unsigned long)r.slowestPhaseNs);
+    n += p.println("ns");
+  }
+  return n;
+}
+
+#if RT_HAS_WATCHDOG_MONITOR
+
+bool LoopWatchdog::startMonitor(uint32_t stallNs, AlarmCallback alarm, void* context) {
+  if (monitorRunning_.exchange(true)) return false;
+  monitor_ = std::thread([this, stallNs, alarm, context] {
+    uint64_t stallTicks = nanosToTicks(stallNs);
+    uint64_t pollNs = stallNs / 4 > 100000u ? stallNs / 4 : 100000u;
+    uint64_t alarmed = 0;
+    while (monitorRunning_.load(std::memory_order_relaxed)) {
+      std::this_thread::sleep_for(std::chrono::nanoseconds(pollNs));
+      uint64_t since = activeSince_.load(std::memory_order_relaxed);
+      if (since == 0 || since == alarmed) continue;
+      uint64_t ticks = (CycleClock::rep)(CycleClock::now() - (CycleClock::rep)(since & ~1ull));
+      if (ticks < stallTicks) continue;
+      alarmed = since;
+      if (alarm != nullptr) alarm(*this, CycleClock::toNanos(ticks), context);
+    }
+  });
+  return true;
+}
+
+void LoopWatchdog::stopMonitor() {
+  if (!monitorRunning_.exchange(false)) return;
+  if (monitor_.joinable()) monitor_.join();
+}
+
+#endif
@@ -0,0 +1,182 @@
+#pragma once
+
+#include "./DiagnosticsDeps.h"
+#include <atomic>
+
+#if defined(__linux__) && !defined(RT_HAS_ARDUINO)
+#define RT_HAS_WATCHDOG_MONITOR 1
+#include <thread>
+#endif
+
+/**
+  * @brief One missed deadline, as captured by LoopWatchdog
+  */
+struct OverrunRecord {
+  uint32_t cycle;          //!< Cycle number, counted from construction or reset()
+  uint32_t durationNs;     //!< Length of the whole cycle
+  uint32_t budgetNs;       //!< The budget it exceeded
+  uint32_t slowestPhaseNs; //!< Time spent in the slowest phase
+  const char* slowestPhase;
+};
+
+/**
+  * @brief Detects and attributes deadline overruns of a periodic loop.
+  *
+  *  Each cycle is bracketed by beginCycle() and endCycle(), and split into
+  *  phases by checkpoint() calls; a checkpoint ends the phase named by it.
+  *  When a cycle takes longer than the budget, the slowest phase is
+  *  written to a small ring that a reporting thread can read at any time
+  *  without stopping the loop: the loop overwrites the oldest records and
+  *  readers detect records that changed under them.
+  *
+  *  Times come from CycleClock, so the cost per cycle is one counter read
+  *  per checkpoint plus one at the start, and a few stores.  Calibrate the
+  *  CycleClock before setting the budget on targets where that is not
+  *  automatic (see CycleClock).
+  *
+  * @code
+  * LoopWatchdog watchdog(1000000);  // 1 ms
+  * for (;;) {
+  *   watchdog.beginCycle();
+  *   readInputs();
+  *   watchdog.checkpoint("inputs");
+  *   runFilter();
+  *   watchdog.checkpoint("filter");
+  *   writeOutputs();
+  *   watchdog.endCycle("outputs");
+  * }
+  * ...
+  * Serial.print(watchdog);
+  * @endcode
+  */
+class LoopWatchdog : public Printable
+{
+public:
+  static constexpr int kRingSize = 16; //!< Overruns kept for reporting, a power of two
+
+  typedef void (*AlarmCallback)(LoopWatchdog& watchdog, uint64_t stalledNs, void* context);
+
+  LoopWatchdog(uint32_t budgetNs);
+  ~LoopWatchdog();
+
+  LoopWatchdog(const LoopWatchdog&) = delete;
+  LoopWatchdog& operator=(const LoopWatchdog&) = delete;
+
+  void setBudget(uint32_t budgetNs);
+  uint32_t budget() const { return budgetNs_; }
+
+  void beginCycle() {
+    CycleClock::rep now = CycleClock::now();
+    cycleStart_ = now;
+    phaseStart_ = now;
+    slowestTicks_ = 0;
+    slowestPhase_ = nullptr;
+    activeSince_.store(now | 1, std::memory_order_relaxed);
+  }
+
+  /**
+    * @brief Ends the phase that started at the previous checkpoint (or at
+    *        beginCycle()) and names it
+    *
+    * @param name A string that outlives the watchdog, usually a literal
+    */
+  void checkpoint(const char* name) {
+    CycleClock::rep now = CycleClock::now();
+    uint64_t ticks = (CycleClock::rep)(now - phaseStart_);
+    if (ticks > slowestTicks_) {
+      slowestTicks_ = ticks;
+      slowestPhase_ = name;
+    }
+    phaseStart_ = now;
+  }
+
+  /**
+    * @brief Ends the cycle, optionally closing a last phase
+    *
+    * @return true If the cycle overran its budget
+    */
+  bool endCycle(const char* lastPhase = nullptr) {
+    CycleClock::rep now;
+    if (lastPhase != nullptr) {
+      checkpoint(lastPhase);
+      now = phaseStart_;
+    }
+    else {
+      now = CycleClock::now();
+    }
+    activeSince_.store(0, std::memory_order_relaxed);
+    uint64_t ticks = (CycleClock::rep)(now - cycleStart_);
+    // Single writer: plain load and store, no read-modify-write
+    cycles_.store(cycles_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    if (ticks > worstTicks_.load(std::memory_order_relaxed)) worstTicks_.store(ticks, std::memory_order_relaxed);
+    if (ticks <= budgetTicks_) return false;
+    recordOverrun(ticks);
+    return true;
+  }
+
+  uint32_t cycleCount() const { return cycles_.load(std::memory_order_relaxed); }
+  uint32_t overrunCount() const { return overruns_.load(std::memory_order_relaxed); }
+  uint64_t worstCycleNs() const { return CycleClock::toNanos(worstTicks_.load(std::memory_order_relaxed)); }
+
+  /**
+    * @brief Copies the most recent overruns, newest first; safe from any
+    *        thread
+    *
+    * @return size_t The number of records copied
+    */
+  size_t readOverruns(OverrunRecord* out, size_t maxRecords) const;
+
+  /**
+    * @brief Clears the counters and the overrun ring; loop thread only
+    */
+  void reset();
+
+  /**
+    * @brief Prints the counters followed by the recent overruns, one per line
+    */
+  size_t printTo(Print& p) const override;
+
+#if RT_HAS_WATCHDOG_MONITOR
+  /**
+    * @brief Starts a thread that calls alarm, from that thread, once for
+    *        every cycle that has been running for longer than stallNs.  Unlike
+    *        the overrun ring this catches loops that never reach endCycle().
+    *
+    * @return false If a monitor is already running
+    */
+  bool startMonitor(uint32_t stallNs, AlarmCallback alarm, void* context = nullptr);
+
+  void stopMonitor();
+#endif
+
+protected:
+  // The fields of an OverrunRecord, held in atomics so that copying them
+  // while the loop writes is race free; the sequence tells a torn copy
+  struct Slot {
+    std::atomic<uint32_t> sequence; //!< Odd while the loop is writing the record
+    std::atomic<uint32_t> cycle;
+    std::atomic<uint32_t> durationNs;
+    std::atomic<uint32_t> budgetNs;
+    std::atomic<uint32_t> slowestPhaseNs;
+    std::atomic<const char*> slowestPhase;
+  };
+
+  uint32_t budgetNs_;
+  uint64_t budgetTicks_;
+  CycleClock::rep cycleStart_;
+  CycleClock::rep phaseStart_;
+  uint64_t slowestTicks_;
+  const char* slowestPhase_;
+  std::atomic<uint32_t> cycles_;
+  std::atomic<uint64_t> worstTicks_;
+  std::atomic<uint32_t> overruns_;
+  std::atomic<uint64_t> activeSince_; //!< Cycle start with the low bit set while a cycle runs, else 0
+  Slot ring_[kRingSize];
+
+#if RT_HAS_WATCHDOG_MONITOR
+  std::thread monitor_;
+  std::atomic<bool> monitorRunning_;
+#endif
+
+  void recordOverrun(uint64_t ticks);
+};
@@ -0,0 +1,79 @@
+#include "Profiler.h"
+
+std::atomic<ProfileSite*> Profiler::head_(nullptr);
+
+ProfileSite::ProfileSite(const char* name, const char* file, int line) :
+  name_(name), file_(file), line_(line), next_(nullptr) {
+  Profiler::add(*this);
+}
+
+void ProfileSite::snapshot(ProfileSnapshot& out) const {
+  out.name = name_;
+  out.file = file_;
+  out.line = line_;
+  out.count = histogram_.count();
+  out.totalNs = CycleClock::toNanos(histogram_.total());
+  out.minNs = CycleClock::toNanos(histogram_.min());
+  out.maxNs = CycleClock::toNanos(histogram_.max());
+  out.p50Ns = CycleClock::toNanos(histogram_.percentile(50.0));
+  out.p90Ns = CycleClock::toNanos(histogram_.percentile(90.0));
+  out.p99Ns = CycleClock::toNanos(histogram_.percentile(99.0));
+  out.p999Ns = CycleClock::toNanos(histogram_.percentile(99.9));
+}
+
+void Profiler::add(ProfileSite& site) {
+  ProfileSite* head = head_.load(std::memory_order_relaxed);
+  do {
+    site.next_ = head;
+  } while (!head_.compare_exchange_weak(head, &site, std::memory_order_release, std::memory_order_relaxed));
+}
+
+size_t Profiler::snapshot(ProfileSnapshot* out, size_t maxSites) {
+  size_t n = 0;
+  for (ProfileSite* site = first(); site != nullptr && n < maxSites; site = site->next()) {
+    site->snapshot(out[n++]);
+  }
+  return n;
+}
+
+void Profiler::reset() {
+  for (ProfileSite* site = first(); site != nullptr; site = site->next()) site->reset();
+}
+
+static size_t printNanos(Print& p, const char* label, uint64_t ns) {
+  size_t n = p.print(label);
+  if (ns >= 10000000ull) {
+    n += p.print((unsigned long)(ns / 1000000ull));
+    n += p.print("ms");
+  }
+  else if (ns >= 10000ull) {
+    n += p.print((unsigned long)(ns / 1000ull));
+    n += p.print("us");
+  }
+  else {
+    n += p.print((unsigned long)ns);
+    n += p.print("ns");
+  }
+  return n;
+}
+
+size_t ProfileReport::printTo(Print& p) const {
+  size_t n = 0;
+  for (ProfileSite* site = Profiler::first(); site != nullptr; site = site->next()) {
+    ProfileSnapshot s;
+    site->snapshot(s);
+    n += p.print(s.name);
+    n += p.print(" count=");
+    n += p.print((unsigned long)s.count);
+    n += printNanos(p, " total=", s.totalNs);
+    n += printNanos(p, " mean=", s.meanNs());
+    n += printNanos(p, " min=", s.minNs);
+    n += printNanos(p, " p50=", s.p50Ns);
+    n += printNanos(p, " p90=", s.p90Ns);
+    n += printNanos(p, " p99=", s.p99Ns);
+    n += printNanos(p, " p99.9=", s.p999Ns);
+    n += printNanos(p, " max=", s.maxNs);
+    n += p.println();
+  }
+  return n;
+}
@@ -0,0 +1,158 @@
+#pragma once
+
+#include "./DiagnosticsDeps.h"
+#include "./LatencyHistogram.h"
+#include <atomic>
+
+/*
+  Hot path profiler.
+
+    void processBlock() {
+      RT_PROFILE_SCOPE("processBlock");
+      ...
+    }
+
+  Each RT_PROFILE_SCOPE gets its own static ProfileSite.  The scope reads the
+  cycle counter on entry and exit and adds the difference to the site with
+  relaxed atomics, so sites may be hit from several threads.  Profiler::report()
+  prints every site with count, mean, min, max and percentiles.
+
+  Profiling is compiled in only when RT_PROFILING is defined to 1; otherwise
+  the macro expands to nothing.
+*/
+
+#ifndef RT_PROFILING
+#define RT_PROFILING 0
+#endif
+
+/**
+  * @brief A point-in-time copy of a ProfileSite's statistics, in nanoseconds
+  */
+struct ProfileSnapshot {
+  const char* name;
+  const char* file;
+  int line;
+  uint64_t count;
+  uint64_t totalNs;
+  uint64_t minNs;
+  uint64_t maxNs;
+  uint64_t p50Ns;
+  uint64_t p90Ns;
+  uint64_t p99Ns;
+  uint64_t p999Ns;
+
+  uint64_t meanNs() const { return count ? totalNs / count : 0; }
+};
+
+/**
+  * @brief Aggregated timings of one profiled scope: a LatencyHistogram of
+  *        cycle counter ticks, converted to nanoseconds when read.
+  */
+class ProfileSite
+{
+public:
+  /**
+    * @brief Registers the site with the Profiler
+    */
+  ProfileSite(const char* name, const char* file = "", int line = 0);
+
+  ProfileSite(const ProfileSite&) = delete;
+  ProfileSite& operator=(const ProfileSite&) = delete;
+
+  void record(uint64_t ticks) { histogram_.record(ticks); }
+
+  /**
+    * @brief Copies the statistics.  Concurrent record() calls may be partly
+    *        included; the copy is not a consistent cut.
+    */
+  void snapshot(ProfileSnapshot& out) const;
+
+  void reset() { histogram_.reset(); }
+
+  const char* name() const { return name_; }
+  ProfileSite* next() const { return next_; }
+
+  /**
+    * @brief The raw durations, in CycleClock ticks
+    */
+  const LatencyHistogram& histogram() const { return histogram_; }
+
+protected:
+  friend class Profiler;
+
+  const char* name_;
+  const char* file_;
+  int line_;
+  ProfileSite* next_;
+  StaticLatencyHistogram<2, 40> histogram_;
+};
+
+/**
+  * @brief Times the enclosing scope into a ProfileSite
+  */
+class ProfileScope
+{
+public:
+  ProfileScope(ProfileSite& site) : site_(site), start_(CycleClock::now()) {};
+
+  ~ProfileScope() {
+    site_.record((CycleClock::rep)(CycleClock::nowOrdered() - start_));
+  }
+
+  ProfileScope(const ProfileScope&) = delete;
+  ProfileScope& operator=(const ProfileScope&) = delete;
+
+protected:
+  ProfileSite& site_;
+  CycleClock::rep start_;
+};
+
+/**
+  * @brief Prints one line per profiled site
+  */
+class ProfileReport : public Printable
+{
+public:
+  size_t printTo(Print& p) const override;
+};
+
+/**
+  * @brief The registry of every ProfileSite in the program
+  */
+class Profiler
+{
+public:
+  static ProfileSite* first() { return head_.load(std::memory_order_acquire); }
+
+  static void add(ProfileSite& site);
+
+  /**
+    * @brief Copies the statistics of up to maxSites sites
+    *
+    * @return size_t The number of snapshots written
+    */
+  static size_t snapshot(ProfileSnapshot* out, size_t maxSites);
+
+  /**
+    * @brief Clears the statistics of every site
+    */
+  static void reset();
+
+  /**
+    * @brief Serial.print(Profiler::report());
+    */
+  static ProfileReport report() { return ProfileReport(); }
+
+protected:
+  static std::atomic<ProfileSite*> head_;
+};
+
+#if RT_PROFILING
+#define RT_PROFILE_CONCAT_(a, b) a##b
+#define RT_PROFILE_CONCAT(a, b) RT_PROFILE_CONCAT_(a, b)
+#define RT_PROFILE_SCOPE(name) \
+  static ProfileSite RT_PROFILE_CONCAT(rtProfileSite_, __LINE__)(name, __FILE__, __LINE__); \
+  ProfileScope RT_PROFILE_CONCAT(rtProfileScope_, __LINE__)(RT_PROFILE_CONCAT(rtProfileSite_, __LINE__))
+#else
+#define RT_PROFILE_SCOPE(name)
+#endif
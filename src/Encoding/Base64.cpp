@@ -0,0 +1,111 @@
+#include "Base64.h"
+#include "SimdSupport.h"
+
+static const char kAlphabet[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+
+static void encodeScalar(const uint8_t* data, size_t size, char* out) {
+  size_t i = 0;
+  for (; i + 3 <= size; i += 3) {
+    uint32_t v = (data[i] << 16) | (data[i + 1] << 8) | data[i + 2];
+    *out++ = kAlphabet[(v >> 18) & 0x3f];
+    *out++ = kAlphabet[(v >> 12) & 0x3f];
+    *out++ = kAlphabet[(v >> 6) & 0x3f];
+    *out++ = kAlphabet[v & 0x3f];
+  }
+  size_t rest = size - i;
+  if (rest) {
+    uint32_t v = data[i] << 16;
+    if (rest == 2) v |= data[i + 1] << 8;
+    *out++ = kAlphabet[(v >> 18) & 0x3f];
+    *out++ = kAlphabet[(v >> 12) & 0x3f];
+    *out++ = rest == 2 ? kAlphabet[(v >> 6) & 0x3f] : '=';
+    *out++ = '=';
+  }
+}
+
+#if RT_SIMD_X86
+// Wojciech Mula's pshufb based encoder: 12 input bytes -> 16 characters.
+RT_TARGET_SSSE3
+static size_t encodeSSSE3(const uint8_t* data, size_t size, char* out) {
+  const __m128i split = _mm_set_epi8(10, 11, 9, 10, 7, 8, 6, 7, 4, 5, 3, 4, 1, 2, 0, 1);
+  const __m128i shiftLut = _mm_setr_epi8(
+    'a' - 26, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52,
+    '0' - 52, '0' - 52, '0' - 52, '0' - 52, '0' - 52, '+' - 62,
+    '/' - 63, 'A', 0, 0);
+  size_t i = 0;
+  // Each iteration loads 16 bytes but consumes 12
+  for (; i + 16 <= size; i += 12) {
+    __m128i in = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(data + i)), split);
+    __m128i t0 = _mm_and_si128(in, _mm_set1_epi32(0x0fc0fc00));
+    __m128i t1 = _mm_mulhi_epu16(t0, _mm_set1_epi32(0x04000040));
+    __m128i t2 = _mm_and_si128(in, _mm_set1_epi32(0x003f03f0));
+    __m128i t3 = _mm_mullo_epi16(t2, _mm_set1_epi32(0x01000010));
+    __m128i indices = _mm_or_si128(t1, t3);
+
+    // 0..25 -> 13, 26..51 -> 0, 52..61 -> 1..10, 62 -> 11, 63 -> 12
+    __m128i lutIndex = _mm_subs_epu8(indices, _mm_set1_epi8(51));
+    __m128i upper = _mm_cmpgt_epi8(_mm_set1_epi8(26), indices);
+    lutIndex = _mm_or_si128(lutIndex, _mm_and_si128(upper, _mm_set1_epi8(13)));
+    __m128i chars = _mm_add_epi8(_mm_shuffle_epi8(shiftLut, lutIndex), indices);
+    _mm_storeu_si128((__m128i*)out, chars);
+    out += 16;
+  }
+  return i;
+}
+#endif
+
+void Base64::encode(const uint8_t* data, size_t size, char* out) {
+  size_t done = 0;
+#if RT_SIMD_X86
+  if (SimdSupport::hasSSSE3()) done = encodeSSSE3(data, size, out);
+#endif
+  encodeScalar(data + done, size - done, out + encodedLength(done));
+}
+
+static inline int decodeChar(char c) {
+  if (c >= 'A' && c <= 'Z') return c - 'A';
+  if (c >= 'a' && c <= 'z') return c - 'a' + 26;
+  if (c >= '0' && c <= '9') return c - '0' + 52;
+  if (c == '+') return 62;
+  if (c == '/') return 63;
+  return -1;
+}
+
+int Base64::decode(const char* text, size_t length, uint8_t* out, size_t capacity) {
+  if (length % 4 == 0 && length >= 2) {
+    if (text[length - 1] == '=') length--;
+    if (text[length - 1] == '=') length--;
+  }
+  if (length % 4 == 1) return -1;
+  size_t outLength = decodedLength(length);
+  if (outLength > capacity) return -1;
+
+  uint32_t acc = 0;
+  int bits = 0;
+  uint8_t* op = out;
+  for (size_t i = 0; i < length; i++) {
+    int v = decodeChar(text[i]);
+    if (v < 0) return -1;
+    acc = (acc << 6) | (uint32_t)v;
+    bits += 6;
+    if (bits >= 8) {
+      bits -= 8;
+      *op++ = (uint8_t)(acc >> bits);
+    }
+  }
+  return (int)(op - out);
+}
+
+size_t Base64::print(Print& p, const uint8_t* data, size_t size) {
+  char chunk[256];
+  constexpr size_t kBytesPerChunk = (sizeof(chunk) / 4) * 3;
+  size_t n = 0;
+  while (size) {
+    size_t count = size < kBytesPerChunk ? size : kBytesPerChunk;
+    encode(data, count, chunk);
+    n += p.write(chunk, encodedLength(count));
+    data += count;
+    size -= count;
+  }
+  return n;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+/**
+  * @brief Standard (RFC 4648) base64 encoding with padding.
+  *
+  *  Encoding uses an SSSE3 kernel on x86 when available.  Decoding accepts
+  *  padded or unpadded input and rejects anything outside the alphabet.
+  */
+class Base64
+{
+public:
+  /**
+    * @brief Number of characters produced for size input bytes
+    */
+  static constexpr size_t encodedLength(size_t size) {
+    return ((size + 2) / 3) * 4;
+  }
+
+  /**
+    * @brief Upper bound on the bytes produced by decoding length characters
+    */
+  static constexpr size_t decodedLength(size_t length) {
+    return (length / 4) * 3 + ((length % 4) * 3) / 4;
+  }
+
+  /**
+    * @brief Encodes size bytes into encodedLength(size) characters. No
+    *        terminator is written.
+    */
+  static void encode(const uint8_t* data, size_t size, char* out);
+
+  /**
+    * @brief Decodes base64 text
+    *
+    * @return int The number of bytes written, or -1 if the input is malformed
+    *         or does not fit in capacity
+    */
+  static int decode(const char* text, size_t length, uint8_t* out, size_t capacity);
+
+  static int decode(StringRef text, uint8_t* out, size_t capacity) {
+    return decode(text, text.length(), out, capacity);
+  }
+
+  /**
+    * @brief Prints the base64 encoding of size bytes
+    *
+    * @return size_t The number of characters written
+    */
+  static size_t print(Print& p, const uint8_t* data, size_t size);
+};
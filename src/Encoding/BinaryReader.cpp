@@ -0,0 +1,128 @@
+#include "BinaryReader.h"
+#include "BinaryWriter.h"
+#include <string.h>
+
+bool BinaryReader::readVarint(uint64_t& value) {
+  if (error_) return false;
+  uint64_t v = 0;
+  size_t pos = position_;
+  for (size_t i = 0; i < BinaryWriter::kMaxVarintLength; i++) {
+    if (pos >= size_) return fail();
+    uint8_t b = data_[pos++];
+    // The tenth byte may only carry the top bit of a 64 bit value
+    if (i == BinaryWriter::kMaxVarintLength - 1 && b > 1) return fail();
+    v |= (uint64_t)(b & 0x7f) << (7 * i);
+    if (!(b & 0x80)) {
+      position_ = pos;
+      value = v;
+      return true;
+    }
+  }
+  return fail();
+}
+
+bool BinaryReader::readLittleEndian(uint64_t& value, size_t size) {
+  if (error_ || remaining() < size) return fail();
+  uint64_t v = 0;
+  for (size_t i = 0; i < size; i++) {
+    v |= (uint64_t)data_[position_ + i] << (8 * i);
+  }
+  position_ += size;
+  value = v;
+  return true;
+}
+
+bool BinaryReader::readByte(uint8_t& value) {
+  uint64_t v;
+  if (!readLittleEndian(v, 1)) return false;
+  value = (uint8_t)v;
+  return true;
+}
+
+bool BinaryReader::readBool(bool& value) {
+  uint8_t b;
+  if (!readByte(b)) return false;
+  if (b > 1) return fail();
+  value = b != 0;
+  return true;
+}
+
+bool BinaryReader::readFixed16(uint16_t& value) {
+  uint64_t v;
+  if (!readLittleEndian(v, 2)) return false;
+  value = (uint16_t)v;
+  return true;
+}
+
+bool BinaryReader::readFixed32(uint32_t& value) {
+  uint64_t v;
+  if (!readLittleEndian(v, 4)) return false;
+  value = (uint32_t)v;
+  return true;
+}
+
+bool BinaryReader::readFixed64(uint64_t& value) {
+  return readLittleEndian(value, 8);
+}
+
+bool BinaryReader::readFloat(float& value) {
+  uint32_t bits;
+  if (!readFixed32(bits)) return false;
+  memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+bool BinaryReader::readDouble(double& value) {
+  uint64_t bits;
+  if (!readFixed64(bits)) return false;
+  memcpy(&value, &bits, sizeof(value));
+  return true;
+}
+
+bool BinaryReader::readBytes(const uint8_t*& data, size_t& size) {
+  size_t start = position_;
+  uint64_t length;
+  if (!readVarint(length)) return false;
+  if (length > remaining()) {
+    position_ = start;
+    return fail();
+  }
+  data = data_ + position_;
+  size = (size_t)length;
+  position_ += size;
+  return true;
+}
+
+bool BinaryReader::readString(StringSpan& str) {
+  const uint8_t* data;
+  size_t size;
+  if (!readBytes(data, size)) return false;
+  str = StringSpan((const char*)data, size);
+  return true;
+}
+
+bool BinaryReader::peekSchemaId(uint32_t& id) {
+  size_t start = position_;
+  uint32_t v;
+  if (!readVarint(v)) return false;
+  position_ = start;
+  id = v;
+  return true;
+}
+
+bool BinaryReader::readMessage(Serializable& obj) {
+  size_t start = position_;
+  uint32_t id;
+  if (!readVarint(id)) return false;
+  if (id != obj.schemaId()) {
+    position_ = start;
+    return fail();
+  }
+  return read(obj);
+}
+
+bool BinaryReader::skip(size_t size) {
+  if (error_ || remaining() < size) return fail();
+  position_ += size;
+  return true;
+}
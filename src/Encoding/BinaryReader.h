@@ -0,0 +1,110 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+#include "./Serializable.h"
+#include "../Strings/StringSpan.h"
+
+/**
+  * @brief Decoder for data produced by BinaryWriter, reading from a byte
+  *        buffer in memory.
+  *
+  *  Strings and byte arrays are returned as views into the buffer, nothing is
+  *  copied.  Every read checks the remaining length; a failed read returns
+  *  false, latches the error flag and leaves the output untouched.
+  */
+class BinaryReader
+{
+public:
+  BinaryReader(const uint8_t* data, size_t size) :
+    data_(data), size_(data != nullptr ? size : 0), position_(0), error_(false) {};
+
+  bool readVarint(uint64_t& value);
+
+  /**
+    * @brief Reads a varint into a narrower unsigned type, failing if the
+    *        value does not fit
+    */
+  template<typename T>
+  bool readVarint(T& value) {
+    uint64_t v;
+    if (!readVarint(v)) return false;
+    if ((uint64_t)(T)v != v) return fail();
+    value = (T)v;
+    return true;
+  }
+
+  bool readSigned(int64_t& value) {
+    uint64_t v;
+    if (!readVarint(v)) return false;
+    value = (int64_t)(v >> 1) ^ -(int64_t)(v & 1);
+    return true;
+  }
+
+  template<typename T>
+  bool readSigned(T& value) {
+    int64_t v;
+    if (!readSigned(v)) return false;
+    if ((int64_t)(T)v != v) return fail();
+    value = (T)v;
+    return true;
+  }
+
+  bool readByte(uint8_t& value);
+  bool readBool(bool& value);
+  bool readFixed16(uint16_t& value);
+  bool readFixed32(uint32_t& value);
+  bool readFixed64(uint64_t& value);
+  bool readFloat(float& value);
+  bool readDouble(double& value);
+
+  /**
+    * @brief Reads a length prefixed string as a view into the buffer
+    */
+  bool readString(StringSpan& str);
+
+  /**
+    * @brief Reads a length prefixed byte array as a view into the buffer
+    */
+  bool readBytes(const uint8_t*& data, size_t& size);
+
+  /**
+    * @brief Reads an embedded object written with BinaryWriter::write()
+    */
+  bool read(Serializable& obj) {
+    return !error_ && obj.deserializeFrom(*this);
+  }
+
+  /**
+    * @brief Reads a message written with BinaryWriter::writeMessage(),
+    *        failing if its schema id is not obj.schemaId()
+    */
+  bool readMessage(Serializable& obj);
+
+  /**
+    * @brief Returns the schema id of the next message without consuming it,
+    *        so the caller can choose the type to decode into
+    */
+  bool peekSchemaId(uint32_t& id);
+
+  bool skip(size_t size);
+
+  size_t position() const { return position_; }
+
+  size_t remaining() const { return size_ - position_; }
+
+  bool atEnd() const { return position_ == size_; }
+
+  bool hasError() const { return error_; }
+
+protected:
+  const uint8_t* data_;
+  size_t size_;
+  size_t position_;
+  bool error_;
+
+  bool fail() {
+    error_ = true;
+    return false;
+  }
+  bool readLittleEndian(uint64_t& value, size_t size);
+};
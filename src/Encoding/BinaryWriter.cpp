@@ -0,0 +1,69 @@
+#include "BinaryWriter.h"
+#include <string.h>
+
+static size_t encodeVarint(uint64_t value, uint8_t* out) {
+  size_t n = 0;
+  while (value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+static void encodeLittleEndian(uint64_t value, uint8_t* out, size_t size) {
+  for (size_t i = 0; i < size; i++) {
+    out[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+size_t BinaryWriter::writeVarint(uint64_t value) {
+  uint8_t buf[kMaxVarintLength];
+  return emit(buf, encodeVarint(value, buf));
+}
+
+size_t BinaryWriter::writeFixed16(uint16_t value) {
+  uint8_t buf[2];
+  encodeLittleEndian(value, buf, sizeof(buf));
+  return emit(buf, sizeof(buf));
+}
+
+size_t BinaryWriter::writeFixed32(uint32_t value) {
+  uint8_t buf[4];
+  encodeLittleEndian(value, buf, sizeof(buf));
+  return emit(buf, sizeof(buf));
+}
+
+size_t BinaryWriter::writeFixed64(uint64_t value) {
+  uint8_t buf[8];
+  encodeLittleEndian(value, buf, sizeof(buf));
+  return emit(buf, sizeof(buf));
+}
+
+size_t BinaryWriter::writeFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return writeFixed32(bits);
+}
+
+size_t BinaryWriter::writeDouble(double value) {
+  uint64_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return writeFixed64(bits);
+}
+
+size_t BinaryWriter::writeString(StringSpan str) {
+  return writeBytes((const uint8_t*)str.data(), str.length());
+}
+
+size_t BinaryWriter::writeBytes(const uint8_t* data, size_t size) {
+  // Short payloads go out together with their length prefix
+  uint8_t buf[64];
+  size_t prefix = encodeVarint(size, buf);
+  if (size <= sizeof(buf) - prefix) {
+    memcpy(buf + prefix, data, size);
+    return emit(buf, prefix + size);
+  }
+  size_t n = emit(buf, prefix);
+  return n + emit(data, size);
+}
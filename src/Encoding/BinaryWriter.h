@@ -0,0 +1,93 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+#include "./Serializable.h"
+#include "../Strings/StringSpan.h"
+
+/**
+  * @brief Compact binary encoder on top of any Print.
+  *
+  *  Integers are written as LEB128 varints (signed values zigzag encoded so
+  *  small negative numbers stay small), floats as fixed width little endian
+  *  IEEE 754, and strings and byte arrays with a varint length prefix.  Each
+  *  field is assembled on the stack and handed to the Print in one write.
+  *
+  *  A short write latches the error flag; the byte counts returned by each
+  *  call are what the Print accepted.
+  */
+class BinaryWriter
+{
+public:
+  static constexpr size_t kMaxVarintLength = 10;
+
+  BinaryWriter(Print& out) : out_(out), bytesWritten_(0), error_(false) {};
+
+  size_t writeVarint(uint64_t value);
+
+  /**
+    * @brief Writes a signed integer as a zigzag encoded varint
+    */
+  size_t writeSigned(int64_t value) {
+    return writeVarint(((uint64_t)value << 1) ^ (uint64_t)(value >> 63));
+  }
+
+  size_t writeByte(uint8_t value) { return emit(&value, 1); }
+  size_t writeBool(bool value) { return writeByte(value ? 1 : 0); }
+  size_t writeFixed16(uint16_t value);
+  size_t writeFixed32(uint32_t value);
+  size_t writeFixed64(uint64_t value);
+  size_t writeFloat(float value);
+  size_t writeDouble(double value);
+
+  /**
+    * @brief Writes a varint length followed by the characters
+    */
+  size_t writeString(StringSpan str);
+
+  /**
+    * @brief Writes a varint length followed by the bytes
+    */
+  size_t writeBytes(const uint8_t* data, size_t size);
+
+  /**
+    * @brief Writes an embedded object (no schema id, no length)
+    */
+  size_t write(const Serializable& obj) { return obj.serializeTo(*this); }
+
+  /**
+    * @brief Writes a top level message: the object's schema id as a varint
+    *        followed by its fields
+    */
+  size_t writeMessage(const Serializable& obj) {
+    size_t n = writeVarint(obj.schemaId());
+    return n + obj.serializeTo(*this);
+  }
+
+  size_t bytesWritten() const { return bytesWritten_; }
+
+  bool hasError() const { return error_; }
+
+  /**
+    * @brief Number of bytes writeVarint() produces for value
+    */
+  static size_t varintLength(uint64_t value) {
+    size_t n = 1;
+    while (value >= 0x80) {
+      value >>= 7;
+      n++;
+    }
+    return n;
+  }
+
+protected:
+  Print& out_;
+  size_t bytesWritten_;
+  bool error_;
+
+  size_t emit(const uint8_t* data, size_t size) {
+    size_t n = out_.write(data, size);
+    if (n != size) error_ = true;
+    bytesWritten_ += n;
+    return n;
+  }
+};
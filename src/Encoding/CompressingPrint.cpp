@@ -0,0 +1,131 @@
+#include "CompressingPrint.h"
+#include <string.h>
+
+CompressingPrint::CompressingPrint(Print& out, uint8_t* block, uint8_t* scratch, size_t blockSize,
+  uint16_t* hashTable, uint8_t hashLog) :
+  out_(out), block_(block), scratch_(scratch), hashTable_(hashTable),
+  blockSize_(blockSize > LZBlock::kMaxBlockSize ? LZBlock::kMaxBlockSize : blockSize),
+  hashLog_(hashLog), fill_(0), bytesIn_(0), bytesOut_(0)
+{
+  memset(hashTable_, 0, sizeof(uint16_t) << hashLog_);
+}
+
+size_t CompressingPrint::write(const uint8_t* buffer, size_t size) {
+  size_t remaining = size;
+  while (remaining) {
+    size_t room = blockSize_ - fill_;
+    size_t toCopy = remaining < room ? remaining : room;
+    memcpy(block_ + fill_, buffer, toCopy);
+    fill_ += toCopy;
+    buffer += toCopy;
+    remaining -= toCopy;
+    if (fill_ == blockSize_) emitBlock();
+  }
+  return size;
+}
+
+void CompressingPrint::flush() {
+  if (fill_) emitBlock();
+  out_.flush();
+}
+
+void CompressingPrint::finish() {
+  if (fill_) emitBlock();
+  emitHeader(0);
+  out_.flush();
+}
+
+void CompressingPrint::emitBlock() {
+  bytesIn_ += fill_;
+  // Anything that does not shrink is stored, so scratch never needs more
+  // room than the block itself.
+  size_t packed = LZBlock::compress(block_, fill_, scratch_, fill_ - 1, hashTable_, hashLog_);
+  if (packed) {
+    emitHeader((uint32_t)packed);
+    emit(scratch_, packed);
+  }
+  else {
+    emitHeader((uint32_t)fill_ | kStoredFlag);
+    emit(block_, fill_);
+  }
+  fill_ = 0;
+}
+
+void CompressingPrint::emit(const uint8_t* data, size_t size) {
+  size_t n = out_.write(data, size);
+  bytesOut_ += n;
+  if (n != size) setWriteError();
+}
+
+void CompressingPrint::emitHeader(uint32_t header) {
+  uint8_t bytes[kHeaderSize] = {
+    (uint8_t)header, (uint8_t)(header >> 8), (uint8_t)(header >> 16), (uint8_t)(header >> 24)
+  };
+  emit(bytes, kHeaderSize);
+}
+
+DecompressingPrint::DecompressingPrint(Print& out, uint8_t* input, uint8_t* output, size_t blockSize) :
+  out_(out), input_(input), output_(output), blockSize_(blockSize)
+{
+  reset();
+}
+
+void DecompressingPrint::reset() {
+  headerFill_ = 0;
+  blockLength_ = 0;
+  fill_ = 0;
+  stored_ = false;
+  failed_ = false;
+  finished_ = false;
+  clearWriteError();
+}
+
+size_t DecompressingPrint::write(const uint8_t* buffer, size_t size) {
+  size_t consumed = 0;
+  while (consumed < size) {
+    if (failed_) return consumed;
+
+    if (headerFill_ < CompressingPrint::kHeaderSize) {
+      header_[headerFill_++] = buffer[consumed++];
+      if (headerFill_ < CompressingPrint::kHeaderSize) continue;
+      uint32_t header = header_[0] | (header_[1] << 8) | (header_[2] << 16) | ((uint32_t)header_[3] << 24);
+      stored_ = (header & CompressingPrint::kStoredFlag) != 0;
+      blockLength_ = header & ~CompressingPrint::kStoredFlag;
+      fill_ = 0;
+      if (blockLength_ == 0) {
+        finished_ = true;
+        headerFill_ = 0;
+      }
+      else if (blockLength_ > blockSize_) {
+        failed_ = true;
+        setWriteError();
+      }
+      continue;
+    }
+
+    size_t room = blockLength_ - fill_;
+    size_t available = size - consumed;
+    size_t toCopy = available < room ? available : room;
+    memcpy(input_ + fill_, buffer + consumed, toCopy);
+    fill_ += toCopy;
+    consumed += toCopy;
+    if (fill_ == blockLength_) {
+      headerFill_ = 0;
+      if (!decodeBlock()) {
+        failed_ = true;
+        setWriteError();
+      }
+    }
+  }
+  return consumed;
+}
+
+bool DecompressingPrint::decodeBlock() {
+  finished_ = false;
+  if (stored_) {
+    return out_.write(input_, blockLength_) == blockLength_;
+  }
+  int n = LZBlock::decompress(input_, blockLength_, output_, blockSize_);
+  if (n < 0) return false;
+  return out_.write(output_, (size_t)n) == (size_t)n;
+}
@@ -0,0 +1,177 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+#include "./LZBlock.h"
+
+/**
+  * @brief A Print adapter that LZ compresses everything written to it before
+  *        passing it on to another Print.
+  *
+  *  Output is buffered into blocks of a fixed size.  Each block is emitted as
+  *  a 4 byte little endian size header followed by an LZ4 block, the same
+  *  layout LZ4 frames use for their data blocks: if the high bit of the header
+  *  is set the block did not compress and is stored as is.  finish() writes a
+  *  zero header as an end mark.
+  *
+  *  All memory is supplied by the caller, see StaticCompressingPrint for a
+  *  version that owns its storage.
+  */
+class CompressingPrint : public Print
+{
+public:
+  static constexpr uint32_t kStoredFlag = 0x80000000u; //!< Header bit marking an uncompressed block
+  static constexpr size_t kHeaderSize = 4;
+
+  /**
+    * @brief Construct a new CompressingPrint
+    *
+    * @param out The Print that receives the compressed stream
+    * @param block Input buffer of blockSize bytes
+    * @param scratch Output buffer of blockSize bytes
+    * @param blockSize The block size, at most LZBlock::kMaxBlockSize
+    * @param hashTable Match finder table of (1 << hashLog) entries
+    * @param hashLog Log2 of the hash table size (1 to 16)
+    */
+  CompressingPrint(Print& out, uint8_t* block, uint8_t* scratch, size_t blockSize,
+    uint16_t* hashTable, uint8_t hashLog);
+
+  size_t write(uint8_t c) override {
+    block_[fill_++] = c;
+    if (fill_ == blockSize_) emitBlock();
+    return 1;
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override;
+
+  int availableForWrite() override {
+    return (int)(blockSize_ - fill_);
+  }
+
+  /**
+    * @brief Compresses and emits any buffered data as a (short) block, then
+    *        flushes the downstream Print.
+    */
+  void flush() override;
+
+  /**
+    * @brief Flushes and writes the end of stream mark
+    */
+  void finish();
+
+  /**
+    * @brief Total number of uncompressed bytes accepted
+    */
+  uint32_t bytesIn() const { return bytesIn_; }
+
+  /**
+    * @brief Total number of bytes passed on to the downstream Print
+    */
+  uint32_t bytesOut() const { return bytesOut_; }
+
+protected:
+  Print& out_;
+  uint8_t* const block_;
+  uint8_t* const scratch_;
+  uint16_t* const hashTable_;
+  const size_t blockSize_;
+  const uint8_t hashLog_;
+  size_t fill_;
+  uint32_t bytesIn_;
+  uint32_t bytesOut_;
+
+  void emitBlock();
+  void emit(const uint8_t* data, size_t size);
+  void emitHeader(uint32_t header);
+};
+
+/**
+  * @brief CompressingPrint with statically sized block and hash table storage.
+  *
+  * @tparam BLOCK_SIZE The block (and match window) size in bytes
+  * @tparam HASH_LOG Log2 of the number of hash table entries
+  */
+template<size_t BLOCK_SIZE = 4096, uint8_t HASH_LOG = 10>
+class StaticCompressingPrint : public CompressingPrint
+{
+  static_assert(BLOCK_SIZE > 0 && BLOCK_SIZE <= LZBlock::kMaxBlockSize, "BLOCK_SIZE must be between 1 and 65535");
+  static_assert(HASH_LOG > 0 && HASH_LOG <= 16, "HASH_LOG must be between 1 and 16");
+public:
+  StaticCompressingPrint(Print& out) :
+    CompressingPrint(out, sblock_, sscratch_, BLOCK_SIZE, stable_, HASH_LOG) {};
+protected:
+  uint8_t sblock_[BLOCK_SIZE];
+  uint8_t sscratch_[BLOCK_SIZE];
+  uint16_t stable_[1u << HASH_LOG];
+};
+
+/**
+  * @brief The matching decoder: a Print that accepts the stream produced by
+  *        CompressingPrint and writes the decompressed data to another Print.
+  *
+  *  Compressed bytes can be fed in arbitrary pieces.  A block larger than the
+  *  configured block size, or a corrupt block, sets the write error and
+  *  further input is rejected until reset() is called.
+  */
+class DecompressingPrint : public Print
+{
+public:
+  /**
+    * @brief Construct a new DecompressingPrint
+    *
+    * @param out The Print that receives the decompressed data
+    * @param input Buffer of blockSize bytes for the compressed block
+    * @param output Buffer of blockSize bytes for the decompressed block
+    * @param blockSize The block size used by the compressor
+    */
+  DecompressingPrint(Print& out, uint8_t* input, uint8_t* output, size_t blockSize);
+
+  size_t write(uint8_t c) override {
+    return write(&c, 1);
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override;
+
+  void flush() override { out_.flush(); }
+
+  /**
+    * @brief Clears the error state and prepares for a new stream
+    */
+  void reset();
+
+  /**
+    * @brief Returns true once the end of stream mark has been seen
+    */
+  bool finished() const { return finished_; }
+
+protected:
+  Print& out_;
+  uint8_t* const input_;
+  uint8_t* const output_;
+  const size_t blockSize_;
+  uint8_t header_[CompressingPrint::kHeaderSize];
+  size_t headerFill_;
+  size_t blockLength_;
+  size_t fill_;
+  bool stored_;
+  bool failed_;
+  bool finished_;
+
+  bool decodeBlock();
+};
+
+/**
+  * @brief DecompressingPrint with statically sized buffers.
+  *
+  * @tparam BLOCK_SIZE Must match the block size of the compressor
+  */
+template<size_t BLOCK_SIZE = 4096>
+class StaticDecompressingPrint : public DecompressingPrint
+{
+  static_assert(BLOCK_SIZE > 0 && BLOCK_SIZE <= LZBlock::kMaxBlockSize, "BLOCK_SIZE must be between 1 and 65535");
+public:
+  StaticDecompressingPrint(Print& out) :
+    DecompressingPrint(out, sinput_, soutput_, BLOCK_SIZE) {};
+protected:
+  uint8_t sinput_[BLOCK_SIZE];
+  uint8_t soutput_[BLOCK_SIZE];
+};
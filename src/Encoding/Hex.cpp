@@ -0,0 +1,138 @@
+#include "Hex.h"
+#include "SimdSupport.h"
+#include <string.h>
+
+static const char kUpperDigits[] = "0123456789ABCDEF";
+static const char kLowerDigits[] = "0123456789abcdef";
+
+static size_t encodeScalar(const uint8_t* data, size_t size, char* out, const char* digits) {
+  for (size_t i = 0; i < size; i++) {
+    uint8_t b = data[i];
+    out[2 * i] = digits[b >> 4];
+    out[2 * i + 1] = digits[b & 0x0f];
+  }
+  return size;
+}
+
+#if RT_SIMD_X86
+RT_TARGET_SSSE3
+static size_t encodeSSSE3(const uint8_t* data, size_t size, char* out, const char* digits) {
+  const __m128i lut = _mm_loadu_si128((const __m128i*)digits);
+  const __m128i mask = _mm_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 16 <= size; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(data + i));
+    __m128i hi = _mm_shuffle_epi8(lut, _mm_and_si128(_mm_srli_epi16(v, 4), mask));
+    __m128i lo = _mm_shuffle_epi8(lut, _mm_and_si128(v, mask));
+    _mm_storeu_si128((__m128i*)(out + 2 * i), _mm_unpacklo_epi8(hi, lo));
+    _mm_storeu_si128((__m128i*)(out + 2 * i + 16), _mm_unpackhi_epi8(hi, lo));
+  }
+  return i;
+}
+
+RT_TARGET_AVX2
+static size_t encodeAVX2(const uint8_t* data, size_t size, char* out, const char* digits) {
+  const __m256i lut = _mm256_broadcastsi128_si256(_mm_loadu_si128((const __m128i*)digits));
+  const __m256i mask = _mm256_set1_epi8(0x0f);
+  size_t i = 0;
+  for (; i + 32 <= size; i += 32) {
+    __m256i v = _mm256_loadu_si256((const __m256i*)(data + i));
+    __m256i hi = _mm256_shuffle_epi8(lut, _mm256_and_si256(_mm256_srli_epi16(v, 4), mask));
+    __m256i lo = _mm256_shuffle_epi8(lut, _mm256_and_si256(v, mask));
+    // Unpacks work per 128 bit lane, so the halves need recombining
+    __m256i a = _mm256_unpacklo_epi8(hi, lo);
+    __m256i b = _mm256_unpackhi_epi8(hi, lo);
+    _mm256_storeu_si256((__m256i*)(out + 2 * i), _mm256_permute2x128_si256(a, b, 0x20));
+    _mm256_storeu_si256((__m256i*)(out + 2 * i + 32), _mm256_permute2x128_si256(a, b, 0x31));
+  }
+  return i;
+}
+#endif
+
+void Hex::encode(const uint8_t* data, size_t size, char* out, bool upperCase) {
+  const char* digits = upperCase ? kUpperDigits : kLowerDigits;
+  size_t done = 0;
+#if RT_SIMD_X86
+  if (SimdSupport::hasAVX2()) done = encodeAVX2(data, size, out, digits);
+  else if (SimdSupport::hasSSSE3()) done = encodeSSSE3(data, size, out, digits);
+#endif
+  encodeScalar(data + done, size - done, out + 2 * done, digits);
+}
+
+static inline int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+int Hex::decode(const char* text, size_t length, uint8_t* out, size_t capacity) {
+  if (length % 2 != 0 || length / 2 > capacity) return -1;
+  for (size_t i = 0; i < length; i += 2) {
+    int hi = hexValue(text[i]);
+    int lo = hexValue(text[i + 1]);
+    if (hi < 0 || lo < 0) return -1;
+    out[i / 2] = (uint8_t)((hi << 4) | lo);
+  }
+  return (int)(length / 2);
+}
+
+size_t Hex::print(Print& p, const uint8_t* data, size_t size, bool upperCase) {
+  char chunk[256];
+  constexpr size_t kBytesPerChunk = sizeof(chunk) / 2;
+  size_t n = 0;
+  while (size) {
+    size_t count = size < kBytesPerChunk ? size : kBytesPerChunk;
+    encode(data, count, chunk, upperCase);
+    n += p.write(chunk, 2 * count);
+    data += count;
+    size -= count;
+  }
+  return n;
+}
+
+size_t Hex::dump(Print& p, const uint8_t* data, size_t size, uint32_t baseOffset) {
+  // "oooooooo  " + 16 * "xx " + 1 + " |" + 16 + "|\r\n"
+  char line[10 + 3 * kDumpBytesPerLine + 1 + 2 + kDumpBytesPerLine + 3];
+  char digits[2 * kDumpBytesPerLine];
+  size_t n = 0;
+  for (size_t lineStart = 0; lineStart < size; lineStart += kDumpBytesPerLine) {
+    size_t count = size - lineStart < kDumpBytesPerLine ? size - lineStart : kDumpBytesPerLine;
+    const uint8_t* bytes = data + lineStart;
+    char* c = line;
+
+    uint8_t offset[4];
+    uint32_t address = baseOffset + (uint32_t)lineStart;
+    for (int i = 0; i < 4; i++) offset[i] = (uint8_t)(address >> (24 - 8 * i));
+    encode(offset, 4, c, false);
+    c += 8;
+    *c++ = ' ';
+    *c++ = ' ';
+
+    encode(bytes, count, digits, false);
+    for (size_t i = 0; i < kDumpBytesPerLine; i++) {
+      if (i == kDumpBytesPerLine / 2) *c++ = ' ';
+      if (i < count) {
+        *c++ = digits[2 * i];
+        *c++ = digits[2 * i + 1];
+      }
+      else {
+        *c++ = ' ';
+        *c++ = ' ';
+      }
+      *c++ = ' ';
+    }
+
+    *c++ = ' ';
+    *c++ = '|';
+    for (size_t i = 0; i < count; i++) {
+      uint8_t b = bytes[i];
+      *c++ = (b >= 0x20 && b < 0x7f) ? (char)b : '.';
+    }
+    *c++ = '|';
+    *c++ = '\r';
+    *c++ = '\n';
+    n += p.write(line, c - line);
+  }
+  return n;
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+/**
+  * @brief Bulk hexadecimal encoding of binary data.
+  *
+  *  Unlike Print::print(b, HEX) every byte produces exactly two digits, and
+  *  output is handed to the Print in large blocks rather than one virtual
+  *  call per character.  SSSE3/AVX2 kernels are used on x86 when available.
+  */
+class Hex
+{
+public:
+  static constexpr size_t kDumpBytesPerLine = 16;
+
+  /**
+    * @brief Encodes size bytes into 2 * size characters. No terminator is written.
+    */
+  static void encode(const uint8_t* data, size_t size, char* out, bool upperCase = true);
+
+  /**
+    * @brief Decodes pairs of hex digits into bytes
+    *
+    * @return int The number of bytes written, or -1 if the input has an odd
+    *         length, contains a non hex character or does not fit in capacity
+    */
+  static int decode(const char* text, size_t length, uint8_t* out, size_t capacity);
+
+  /**
+    * @brief Prints size bytes as 2 * size hex digits
+    *
+    * @return size_t The number of characters written
+    */
+  static size_t print(Print& p, const uint8_t* data, size_t size, bool upperCase = true);
+
+  /**
+    * @brief Prints a canonical hex dump: offset, 16 bytes per line split in
+    *        two groups of eight, and a printable ASCII column.
+    *
+    *  00000000  48 65 6c 6c 6f 2c 20 77  6f 72 6c 64 21 0a        |Hello, world!.|
+    *
+    * @param baseOffset The offset printed for the first byte
+    * @return size_t The number of characters written
+    */
+  static size_t dump(Print& p, const uint8_t* data, size_t size, uint32_t baseOffset = 0);
+};
+
+/**
+  * @brief Prints size bytes as hex digits, two per byte
+  */
+inline size_t printHex(Print& p, const uint8_t* data, size_t size, bool upperCase = true) {
+  return Hex::print(p, data, size, upperCase);
+}
+
+/**
+  * @brief Prints a hex dump with offsets and an ASCII column
+  */
+inline size_t hexDump(Print& p, const uint8_t* data, size_t size, uint32_t baseOffset = 0) {
+  return Hex::dump(p, data, size, baseOffset);
+}
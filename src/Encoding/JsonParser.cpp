@@ -0,0 +1,589 @@
+#include "JsonParser.h"
+#include "SimdSupport.h"
+#include <limits.h>
+#include <stdlib.h>
+#include <string.h>
+
+#if RT_SIMD_X86 && defined(__SSE2__)
+#define RT_JSON_SSE2 1
+#else
+#define RT_JSON_SSE2 0
+#endif
+
+static constexpr size_t kBlockSize = 64;
+
+struct BlockMasks {
+  uint64_t quote;
+  uint64_t backslash;
+  uint64_t structural;
+  uint64_t whitespace;
+  uint64_t control;
+};
+
+static inline int lowestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(v);
+#else
+  int n = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+static inline bool isStructural(char c) {
+  return c == '{' || c == '}' || c == '[' || c == ']' || c == ':' || c == ',';
+}
+
+static inline bool isWhitespace(char c) {
+  return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+}
+
+static inline bool isDigit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+static inline int hexValue(char c) {
+  if (c >= '0' && c <= '9') return c - '0';
+  if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+  if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+  return -1;
+}
+
+#if RT_JSON_SSE2
+static inline uint64_t movemask(__m128i m) {
+  return (uint16_t)_mm_movemask_epi8(m);
+}
+
+static void classify(const char* p, BlockMasks& m) {
+  m = BlockMasks{ 0, 0, 0, 0, 0 };
+  const __m128i lowerCase = _mm_set1_epi8(0x20);
+  const __m128i control = _mm_set1_epi8(0x1f);
+  for (int k = 0; k < 4; k++) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(p + 16 * k));
+    // '[' and ']' differ from '{' and '}' only in bit 5
+    __m128i folded = _mm_or_si128(v, lowerCase);
+    __m128i s = _mm_or_si128(_mm_cmpeq_epi8(folded, _mm_set1_epi8('{')), _mm_cmpeq_epi8(folded, _mm_set1_epi8('}')));
+    s = _mm_or_si128(s, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(':')), _mm_cmpeq_epi8(v, _mm_set1_epi8(','))));
+    __m128i w = _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8(' ')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\t')));
+    w = _mm_or_si128(w, _mm_or_si128(_mm_cmpeq_epi8(v, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(v, _mm_set1_epi8('\r'))));
+    int shift = 16 * k;
+    m.quote |= movemask(_mm_cmpeq_epi8(v, _mm_set1_epi8('"'))) << shift;
+    m.backslash |= movemask(_mm_cmpeq_epi8(v, _mm_set1_epi8('\\'))) << shift;
+    m.structural |= movemask(s) << shift;
+    m.whitespace |= movemask(w) << shift;
+    m.control |= movemask(_mm_cmpeq_epi8(_mm_max_epu8(v, control), control)) << shift;
+  }
+}
+#else
+static void classify(const char* p, BlockMasks& m) {
+  m = BlockMasks{ 0, 0, 0, 0, 0 };
+  for (size_t i = 0; i < kBlockSize; i++) {
+    char c = p[i];
+    uint64_t bit = 1ull << i;
+    if (c == '"') m.quote |= bit;
+    else if (c == '\\') m.backslash |= bit;
+    else if (isStructural(c)) m.structural |= bit;
+    if (isWhitespace(c)) m.whitespace |= bit;
+    if ((uint8_t)c < 0x20) m.control |= bit;
+  }
+}
+#endif
+
+static inline uint64_t prefixXor(uint64_t x) {
+  x ^= x << 1;
+  x ^= x << 2;
+  x ^= x << 4;
+  x ^= x << 8;
+  x ^= x << 16;
+  x ^= x << 32;
+  return x;
+}
+
+static bool validEscapes(StringSpan s) {
+  const char* p = s.data();
+  size_t n = s.length();
+  for (size_t i = 0; i < n; i++) {
+    if (p[i] != '\\') continue;
+    if (++i >= n) return false;
+    switch (p[i]) {
+      case '"': case '\\': case '/': case 'b': case 'f': case 'n': case 'r': case 't':
+        break;
+      case 'u':
+        if (i + 4 >= n) return false;
+        for (int k = 1; k <= 4; k++) {
+          if (hexValue(p[i + k]) < 0) return false;
+        }
+        i += 4;
+        break;
+      default:
+        return false;
+    }
+  }
+  return true;
+}
+
+static bool validNumber(StringSpan s) {
+  const char* p = s.data();
+  size_t n = s.length();
+  size_t i = 0;
+  if (i < n && p[i] == '-') i++;
+  if (i >= n) return false;
+  if (p[i] == '0') i++;
+  else if (isDigit(p[i])) {
+    while (i < n && isDigit(p[i])) i++;
+  }
+  else return false;
+  if (i < n && p[i] == '.') {
+    i++;
+    if (i >= n || !isDigit(p[i])) return false;
+    while (i < n && isDigit(p[i])) i++;
+  }
+  if (i < n && (p[i] == 'e' || p[i] == 'E')) {
+    i++;
+    if (i < n && (p[i] == '+' || p[i] == '-')) i++;
+    if (i >= n || !isDigit(p[i])) return false;
+    while (i < n && isDigit(p[i])) i++;
+  }
+  return i == n;
+}
+
+static uint32_t readHex4(const char* p) {
+  uint32_t v = 0;
+  for (int k = 0; k < 4; k++) v = (v << 4) | (uint32_t)hexValue(p[k]);
+  return v;
+}
+
+static size_t encodeUtf8(uint32_t cp, char* out) {
+  if (cp < 0x80) {
+    out[0] = (char)cp;
+    return 1;
+  }
+  if (cp < 0x800) {
+    out[0] = (char)(0xc0 | (cp >> 6));
+    out[1] = (char)(0x80 | (cp & 0x3f));
+    return 2;
+  }
+  if (cp < 0x10000) {
+    out[0] = (char)(0xe0 | (cp >> 12));
+    out[1] = (char)(0x80 | ((cp >> 6) & 0x3f));
+    out[2] = (char)(0x80 | (cp & 0x3f));
+    return 3;
+  }
+  out[0] = (char)(0xf0 | (cp >> 18));
+  out[1] = (char)(0x80 | ((cp >> 12) & 0x3f));
+  out[2] = (char)(0x80 | ((cp >> 6) & 0x3f));
+  out[3] = (char)(0x80 | (cp & 0x3f));
+  return 4;
+}
+
+/*
+  Decodes an (already validated) escaped string, handing runs of plain
+  characters and single decoded characters to out(const char*, size_t),
+  which returns false to stop.
+*/
+template<typename Out>
+static bool decodeString(StringSpan s, Out out) {
+  const char* p = s.data();
+  size_t n = s.length();
+  size_t runStart = 0;
+  size_t i = 0;
+  while (i < n) {
+    if (p[i] != '\\') {
+      i++;
+      continue;
+    }
+    if (i > runStart && !out(p + runStart, i - runStart)) return false;
+    char decoded[4];
+    size_t decodedLength = 1;
+    char e = p[i + 1];
+    i += 2;
+    switch (e) {
+      case 'b': decoded[0] = '\b'; break;
+      case 'f': decoded[0] = '\f'; break;
+      case 'n': decoded[0] = '\n'; break;
+      case 'r': decoded[0] = '\r'; break;
+      case 't': decoded[0] = '\t'; break;
+      case 'u': {
+        uint32_t cp = readHex4(p + i);
+        i += 4;
+        if (cp >= 0xd800 && cp < 0xdc00) {
+          if (i + 6 <= n && p[i] == '\\' && p[i + 1] == 'u') {
+            uint32_t low = readHex4(p + i + 2);
+            if (low >= 0xdc00 && low < 0xe000) {
+              cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+              i += 6;
+            }
+            else cp = 0xfffd;
+          }
+          else cp = 0xfffd;
+        }
+        else if (cp >= 0xdc00 && cp < 0xe000) cp = 0xfffd;
+        decodedLength = encodeUtf8(cp, decoded);
+        break;
+      }
+      default: decoded[0] = e; break;
+    }
+    if (!out(decoded, decodedLength)) return false;
+    runStart = i;
+  }
+  if (n > runStart) return out(p + runStart, n - runStart);
+  return true;
+}
+
+static const double kPow10[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+JsonParser::JsonParser(const char* json, size_t length, uint8_t maxDepth) :
+  json_(json), length_(json != nullptr ? length : 0), blockStart_(0), nextBlock_(0),
+  tokens_(0), inString_(0), prevEscaped_(0), prevScalar_(0), objectMask_(0), depth_(0),
+  maxDepth_(maxDepth > kMaxDepth ? kMaxDepth : maxDepth), expect_(Expect::Value),
+  token_(JsonToken::None), hasEscapes_(false), text_(), error_(JsonError::None), errorOffset_(0)
+{
+}
+
+JsonToken JsonParser::fail(JsonError e, size_t offset) {
+  if (error_ == JsonError::None) {
+    error_ = e;
+    errorOffset_ = offset;
+  }
+  text_ = StringSpan();
+  return token_ = JsonToken::Error;
+}
+
+bool JsonParser::loadBlock() {
+  const char* p = json_ + nextBlock_;
+  size_t available = length_ - nextBlock_;
+  char padded[kBlockSize];
+  if (available < kBlockSize) {
+    memcpy(padded, p, available);
+    memset(padded + available, ' ', kBlockSize - available);
+    p = padded;
+  }
+  BlockMasks m;
+  classify(p, m);
+
+  // Characters preceded by an odd run of backslashes
+  uint64_t escaped = prevEscaped_;
+  uint64_t backslash = m.backslash & ~escaped;
+  prevEscaped_ = 0;
+  while (backslash) {
+    uint64_t bit = backslash & (0 - backslash);
+    uint64_t following = bit << 1;
+    if (!following) {
+      prevEscaped_ = 1;
+      break;
+    }
+    escaped |= following;
+    backslash &= ~(bit | following);
+  }
+
+  // Bits from each opening quote up to (not including) its closing quote
+  uint64_t quotes = m.quote & ~escaped;
+  uint64_t inside = prefixXor(quotes) ^ inString_;
+  inString_ = 0 - (inside >> 63);
+
+  uint64_t badControl = m.control & inside;
+  if (badControl) {
+    fail(JsonError::InvalidString, nextBlock_ + lowestBit(badControl));
+    return false;
+  }
+
+  uint64_t outside = ~(inside | quotes);
+  uint64_t scalar = outside & ~(m.whitespace | m.structural);
+  uint64_t scalarStart = scalar & ~((scalar << 1) | prevScalar_);
+  prevScalar_ = scalar >> 63;
+
+  tokens_ = (m.structural & outside) | quotes | scalarStart;
+  blockStart_ = nextBlock_;
+  nextBlock_ += kBlockSize;
+  return true;
+}
+
+bool JsonParser::nextPosition(size_t& pos) {
+  while (tokens_ == 0) {
+    if (error_ != JsonError::None || nextBlock_ >= length_) return false;
+    if (!loadBlock()) return false;
+  }
+  pos = blockStart_ + lowestBit(tokens_);
+  tokens_ &= tokens_ - 1;
+  return true;
+}
+
+JsonToken JsonParser::next() {
+  if (error_ != JsonError::None) return token_ = JsonToken::Error;
+  hasEscapes_ = false;
+  text_ = StringSpan();
+  size_t pos;
+  for (;;) {
+    if (!nextPosition(pos)) {
+      if (error_ != JsonError::None) return token_ = JsonToken::Error;
+      if (expect_ == Expect::Done) return token_ = JsonToken::End;
+      return fail(JsonError::UnexpectedEnd, length_);
+    }
+    char c = json_[pos];
+    switch (expect_) {
+      case Expect::Done:
+        return fail(JsonError::TrailingData, pos);
+      case Expect::Colon:
+        if (c != ':') return fail(JsonError::UnexpectedCharacter, pos);
+        expect_ = Expect::Value;
+        continue;
+      case Expect::CommaOrEnd:
+        if (c == ',') {
+          expect_ = (objectMask_ & (1u << (depth_ - 1))) ? Expect::Key : Expect::Value;
+          continue;
+        }
+        if (c == '}') return pop(true, pos);
+        if (c == ']') return pop(false, pos);
+        return fail(JsonError::UnexpectedCharacter, pos);
+      case Expect::KeyOrEnd:
+        if (c == '}') return pop(true, pos);
+        // fall through
+      case Expect::Key:
+        if (c != '"') return fail(JsonError::UnexpectedCharacter, pos);
+        return string(pos, JsonToken::Key);
+      case Expect::ValueOrEnd:
+        if (c == ']') return pop(false, pos);
+        // fall through
+      case Expect::Value:
+        return value(pos);
+    }
+  }
+}
+
+JsonToken JsonParser::value(size_t pos) {
+  char c = json_[pos];
+  if (c == '{') return push(true, pos);
+  if (c == '[') return push(false, pos);
+  if (c == '"') return string(pos, JsonToken::String);
+  if (isStructural(c)) return fail(JsonError::UnexpectedCharacter, pos);
+  return scalar(pos);
+}
+
+JsonToken JsonParser::push(bool object, size_t pos) {
+  if (depth_ >= maxDepth_) return fail(JsonError::TooDeep, pos);
+  depth_++;
+  uint32_t bit = 1u << (depth_ - 1);
+  if (object) objectMask_ |= bit;
+  else objectMask_ &= ~bit;
+  expect_ = object ? Expect::KeyOrEnd : Expect::ValueOrEnd;
+  return token_ = object ? JsonToken::BeginObject : JsonToken::BeginArray;
+}
+
+JsonToken JsonParser::pop(bool object, size_t pos) {
+  bool inObject = depth_ > 0 && (objectMask_ & (1u << (depth_ - 1)));
+  if (depth_ == 0 || inObject != object) return fail(JsonError::UnexpectedCharacter, pos);
+  depth_--;
+  return afterValue(object ? JsonToken::EndObject : JsonToken::EndArray);
+}
+
+JsonToken JsonParser::string(size_t pos, JsonToken type) {
+  // Nothing inside a string produces a token, so the next position is
+  // the closing quote.
+  size_t close;
+  if (!nextPosition(close)) {
+    if (error_ != JsonError::None) return token_ = JsonToken::Error;
+    return fail(JsonError::UnexpectedEnd, pos);
+  }
+  StringSpan s(json_ + pos + 1, close - pos - 1);
+  hasEscapes_ = s.indexOf('\\') >= 0;
+  if (hasEscapes_ && !validEscapes(s)) return fail(JsonError::InvalidString, pos);
+  text_ = s;
+  if (type == JsonToken::Key) {
+    expect_ = Expect::Colon;
+    return token_ = type;
+  }
+  return afterValue(type);
+}
+
+JsonToken JsonParser::scalar(size_t pos) {
+  size_t end = pos;
+  while (end < length_) {
+    char c = json_[end];
+    if (isWhitespace(c) || isStructural(c) || c == '"') break;
+    end++;
+  }
+  StringSpan s(json_ + pos, end - pos);
+  char c = json_[pos];
+  if (c == 't') {
+    if (s != StringSpan("true", 4)) return fail(JsonError::InvalidLiteral, pos);
+    return afterValue(JsonToken::True);
+  }
+  if (c == 'f') {
+    if (s != StringSpan("false", 5)) return fail(JsonError::InvalidLiteral, pos);
+    return afterValue(JsonToken::False);
+  }
+  if (c == 'n') {
+    if (s != StringSpan("null", 4)) return fail(JsonError::InvalidLiteral, pos);
+    return afterValue(JsonToken::Null);
+  }
+  if (c == '-' || isDigit(c)) {
+    if (!validNumber(s)) return fail(JsonError::InvalidNumber, pos);
+    text_ = s;
+    return afterValue(JsonToken::Number);
+  }
+  return fail(JsonError::UnexpectedCharacter, pos);
+}
+
+bool JsonParser::skip() {
+  switch (token_) {
+    case JsonToken::BeginObject:
+    case JsonToken::BeginArray: {
+      uint8_t target = depth_ - 1;
+      while (depth_ > target) {
+        JsonToken t = next();
+        if (t == JsonToken::Error || t == JsonToken::End) return false;
+      }
+      return true;
+    }
+    case JsonToken::Key: {
+      JsonToken t = next();
+      if (t == JsonToken::BeginObject || t == JsonToken::BeginArray) return skip();
+      return t != JsonToken::Error;
+    }
+    default:
+      return token_ != JsonToken::Error;
+  }
+}
+
+int JsonParser::unescape(char* out, size_t capacity) const {
+  size_t length = 0;
+  bool ok = decodeString(text_, [&](const char* p, size_t n) {
+    if (n > capacity - length) return false;
+    memcpy(out + length, p, n);
+    length += n;
+    return true;
+  });
+  return ok ? (int)length : -1;
+}
+
+bool JsonParser::copyString(FixedString& str) const {
+  return decodeString(text_, [&](const char* p, size_t n) {
+    return str.write((const uint8_t*)p, n) == n;
+  });
+}
+
+bool JsonParser::toLong(long& value) const {
+  if (token_ != JsonToken::Number) return false;
+  const char* p = text_.data();
+  size_t n = text_.length();
+  size_t i = 0;
+  bool negative = p[0] == '-';
+  if (negative) i++;
+  unsigned long magnitude = 0;
+  const unsigned long limit = negative ? (unsigned long)LONG_MAX + 1ul : (unsigned long)LONG_MAX;
+  for (; i < n; i++) {
+    if (!isDigit(p[i])) return false;
+    unsigned long d = (unsigned long)(p[i] - '0');
+    if (magnitude > (limit - d) / 10) return false;
+    magnitude = magnitude * 10 + d;
+  }
+  value = negative ? (long)(0ul - magnitude) : (long)magnitude;
+  return true;
+}
+
+bool JsonParser::toDouble(double& value) const {
+  if (token_ != JsonToken::Number) return false;
+  const char* p = text_.data();
+  size_t n = text_.length();
+  size_t i = 0;
+  bool negative = p[0] == '-';
+  if (negative) i++;
+
+  uint64_t mantissa = 0;
+  int digits = 0;
+  int exponent = 0;
+  for (; i < n && isDigit(p[i]); i++) {
+    if (digits < 19) {
+      mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+      if (mantissa) digits++;
+    }
+    else exponent++;
+  }
+  if (i < n && p[i] == '.') {
+    for (i++; i < n && isDigit(p[i]); i++) {
+      if (digits < 19) {
+        mantissa = mantissa * 10 + (uint64_t)(p[i] - '0');
+        if (mantissa) digits++;
+        exponent--;
+      }
+    }
+  }
+  size_t digitsEnd = i;
+  int written = 0; // The exponent after the e
+  if (i < n) {
+    i++;
+    bool negativeExponent = false;
+    if (p[i] == '+' || p[i] == '-') negativeExponent = p[i++] == '-';
+    int e = 0;
+    for (; i < n; i++) {
+      if (e < 10000) e = e * 10 + (p[i] - '0');
+    }
+    written = negativeExponent ? -e : e;
+  }
+  exponent += written;
+
+  // Exactly representable mantissa and power of ten: one correctly rounded
+  // operation (Clinger's fast path).  Anything else goes through strtod.
+  if (digits <= 15 && exponent >= -22 && exponent <= 22) {
+    double d = (double)mantissa;
+    d = exponent < 0 ? d / kPow10[-exponent] : d * kPow10[exponent];
+    value = negative ? -d : d;
+    return true;
+  }
+
+  // strtod gets the significant digits, at most kMaxDigits of them, and an
+  // exponent adjusted for the point and the digits dropped, so a number of
+  // any length fits the buffer.  Dropped digits that are not all zero
+  // become a trailing 1, which keeps the rounding direction except within
+  // 10^-64 of a halfway point.
+  static constexpr int kMaxDigits = 64;
+  char buf[kMaxDigits + 16];
+  size_t length = 0;
+  if (negative) buf[length++] = '-';
+  int kept = 0;
+  int scale = written;
+  bool fraction = false;
+  bool sticky = false;
+  for (i = negative ? 1 : 0; i < digitsEnd; i++) {
+    if (p[i] == '.') {
+      fraction = true;
+      continue;
+    }
+    if (kept == 0 && p[i] == '0') {
+      if (fraction) scale--;
+    }
+    else if (kept < kMaxDigits) {
+      buf[length++] = p[i];
+      kept++;
+      if (fraction) scale--;
+    }
+    else {
+      if (!fraction) scale++;
+      if (p[i] != '0') sticky = true;
+    }
+  }
+  if (kept == 0) buf[length++] = '0';
+  if (sticky) {
+    buf[length++] = '1';
+    scale--;
+  }
+  buf[length++] = 'e';
+  if (scale < 0) buf[length++] = '-';
+  unsigned int magnitude = scale < 0 ? 0u - (unsigned int)scale : (unsigned int)scale;
+  char reversed[10];
+  size_t count = 0;
+  do {
+    reversed[count++] = (char)('0' + magnitude % 10);
+    magnitude /= 10;
+  } while (magnitude > 0);
+  while (count > 0) buf[length++] = reversed[--count];
+  buf[length] = '\0';
+  value = strtod(buf, nullptr);
+  return true;
+}
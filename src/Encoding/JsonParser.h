@@ -0,0 +1,177 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+#include "../Strings/StringSpan.h"
+#include "../Strings/FixedString.h"
+
+enum class JsonToken : uint8_t {
+  None,
+  BeginObject,
+  EndObject,
+  BeginArray,
+  EndArray,
+  Key,
+  String,
+  Number,
+  True,
+  False,
+  Null,
+  End,   //!< The root value is complete and only whitespace follows
+  Error
+};
+
+enum class JsonError : uint8_t {
+  None,
+  UnexpectedEnd,
+  UnexpectedCharacter,
+  InvalidString,
+  InvalidNumber,
+  InvalidLiteral,
+  TooDeep,
+  TrailingData
+};
+
+/**
+  * @brief Validating pull parser for JSON text held in memory.
+  *
+  *  Each call to next() returns one token.  String, key and number tokens are
+  *  exposed through text() as spans of the original input: nothing is copied
+  *  and numbers are only converted when asked for.  Strings are returned with
+  *  their escapes intact; use unescape() or copyString() when hasEscapes() is
+  *  true.
+  *
+  *  The input is classified 64 bytes at a time (SSE2 on x86) into bit masks of
+  *  quotes, backslashes, structural characters and whitespace, from which the
+  *  positions of every token are derived without looking at string contents,
+  *  in the manner of simdjson's first stage.  Only one block of masks is held
+  *  at a time and nesting is tracked in a fixed bit stack, so memory use does
+  *  not depend on the input.
+  *
+  *  @code
+  *  JsonParser json(message);
+  *  JsonToken t;
+  *  while ((t = json.next()) != JsonToken::End && t != JsonToken::Error) {
+  *    if (t == JsonToken::Key && json.text() == "gain") {
+  *      json.next();
+  *      json.toDouble(gain);
+  *    }
+  *  }
+  *  @endcode
+  */
+class JsonParser
+{
+public:
+  static constexpr uint8_t kMaxDepth = 32;
+
+  JsonParser(const char* json, size_t length, uint8_t maxDepth = kMaxDepth);
+  JsonParser(StringRef json, uint8_t maxDepth = kMaxDepth) :
+    JsonParser(json, json.length(), maxDepth) {};
+
+  /**
+    * @brief Advances to the next token
+    */
+  JsonToken next();
+
+  /**
+    * @brief Skips the value that starts with the current token. After a
+    *        BeginObject or BeginArray this consumes up to the matching end,
+    *        after a Key it consumes the key's value.
+    *
+    * @return false If an error was encountered
+    */
+  bool skip();
+
+  JsonToken token() const { return token_; }
+
+  /**
+    * @brief The text of the current String, Key or Number token (without
+    *        quotes, escapes not processed)
+    */
+  StringSpan text() const { return text_; }
+
+  /**
+    * @brief True if the current string token contains escape sequences
+    */
+  bool hasEscapes() const { return hasEscapes_; }
+
+  /**
+    * @brief Decodes the current string token, including \\u escapes, into UTF-8
+    *
+    * @return int The number of bytes written, or -1 if it does not fit
+    */
+  int unescape(char* out, size_t capacity) const;
+
+  /**
+    * @brief Appends the decoded current string token to str
+    *
+    * @return false If it did not fit
+    */
+  bool copyString(FixedString& str) const;
+
+  /**
+    * @brief Converts the current Number token
+    *
+    * @return false If it is not an integer or out of range
+    */
+  bool toLong(long& value) const;
+
+  /**
+    * @brief Converts the current Number token, of any length.  Rounding is
+    *        correct for up to 64 significant digits; beyond that the extra
+    *        digits only decide the direction of rounding.
+    *
+    * @return false If the current token is not a Number
+    */
+  bool toDouble(double& value) const;
+
+  bool toBool(bool& value) const {
+    if (token_ != JsonToken::True && token_ != JsonToken::False) return false;
+    value = token_ == JsonToken::True;
+    return true;
+  }
+
+  uint8_t depth() const { return depth_; }
+
+  JsonError error() const { return error_; }
+
+  /**
+    * @brief Offset into the input at which the error was detected
+    */
+  size_t errorOffset() const { return errorOffset_; }
+
+protected:
+  enum class Expect : uint8_t { Value, ValueOrEnd, Key, KeyOrEnd, Colon, CommaOrEnd, Done };
+
+  const char* json_;
+  size_t length_;
+  // Stage one state: token bits of the current 64 byte block
+  size_t blockStart_;
+  size_t nextBlock_;
+  uint64_t tokens_;
+  uint64_t inString_;
+  uint64_t prevEscaped_;
+  uint64_t prevScalar_;
+  // Stage two state
+  uint32_t objectMask_;
+  uint8_t depth_;
+  uint8_t maxDepth_;
+  Expect expect_;
+  JsonToken token_;
+  bool hasEscapes_;
+  StringSpan text_;
+  JsonError error_;
+  size_t errorOffset_;
+
+  bool nextPosition(size_t& pos);
+  bool loadBlock();
+  JsonToken value(size_t pos);
+  JsonToken string(size_t pos, JsonToken type);
+  JsonToken scalar(size_t pos);
+  JsonToken push(bool object, size_t pos);
+  JsonToken pop(bool object, size_t pos);
+  JsonToken afterValue(JsonToken t) {
+    expect_ = depth_ == 0 ? Expect::Done : Expect::CommaOrEnd;
+    return token_ = t;
+  }
+  JsonToken fail(JsonError e, size_t offset);
+};
@@ -0,0 +1,241 @@
+#include "JsonWriter.h"
+#include "SimdSupport.h"
+#include <math.h>
+#include <string.h>
+
+#if RT_SIMD_X86 && defined(__SSE2__)
+#define RT_JSON_SSE2 1
+#else
+#define RT_JSON_SSE2 0
+#endif
+
+static inline bool needsEscape(uint8_t c) {
+  return c < 0x20 || c == '"' || c == '\\';
+}
+
+size_t JsonWriter::findEscape(const char* str, size_t length) {
+  size_t i = 0;
+#if RT_JSON_SSE2
+  const __m128i quote = _mm_set1_epi8('"');
+  const __m128i backslash = _mm_set1_epi8('\\');
+  const __m128i control = _mm_set1_epi8(0x1f);
+  for (; i + 16 <= length; i += 16) {
+    __m128i v = _mm_loadu_si128((const __m128i*)(str + i));
+    __m128i hit = _mm_or_si128(_mm_cmpeq_epi8(v, quote), _mm_cmpeq_epi8(v, backslash));
+    // v <= 0x1f unsigned  <=>  max(v, 0x1f) == 0x1f
+    hit = _mm_or_si128(hit, _mm_cmpeq_epi8(_mm_max_epu8(v, control), control));
+    int mask = _mm_movemask_epi8(hit);
+    if (mask) return i + __builtin_ctz(mask);
+  }
+#else
+  // Eight bytes at a time using the classic "has zero/less than byte" tricks
+  const uint64_t ones = 0x0101010101010101ull;
+  const uint64_t highs = 0x8080808080808080ull;
+  for (; i + 8 <= length; i += 8) {
+    uint64_t v;
+    memcpy(&v, str + i, sizeof(v));
+    uint64_t q = v ^ (ones * '"');
+    uint64_t b = v ^ (ones * '\\');
+    uint64_t hit = ((q - ones) & ~q) | ((b - ones) & ~b) | ((v - ones * 0x20) & ~v);
+    if (hit & highs) break;
+  }
+#endif
+  for (; i < length; i++) {
+    if (needsEscape((uint8_t)str[i])) return i;
+  }
+  return length;
+}
+
+size_t JsonWriter::printString(Print& p, const char* str, size_t length) {
+  static const char kDigits[] = "0123456789abcdef";
+  size_t n = p.write((uint8_t)'"');
+  while (length) {
+    size_t clean = findEscape(str, length);
+    if (clean) n += p.write(str, clean);
+    str += clean;
+    length -= clean;
+    if (!length) break;
+
+    char esc[6] = { '\\', 0, 0, 0, 0, 0 };
+    size_t escLength = 2;
+    uint8_t c = (uint8_t)*str++;
+    length--;
+    switch (c) {
+      case '"': esc[1] = '"'; break;
+      case '\\': esc[1] = '\\'; break;
+      case '\b': esc[1] = 'b'; break;
+      case '\f': esc[1] = 'f'; break;
+      case '\n': esc[1] = 'n'; break;
+      case '\r': esc[1] = 'r'; break;
+      case '\t': esc[1] = 't'; break;
+      default:
+        esc[1] = 'u';
+        esc[2] = '0';
+        esc[3] = '0';
+        esc[4] = kDigits[c >> 4];
+        esc[5] = kDigits[c & 0x0f];
+        escLength = 6;
+        break;
+    }
+    n += p.write(esc, escLength);
+  }
+  n += p.write((uint8_t)'"');
+  return n;
+}
+
+bool JsonWriter::beginValue() {
+  if (error_) return false;
+  if (depth_ == 0) {
+    if (rootWritten_) return false;
+    rootWritten_ = true;
+    return true;
+  }
+  if (inObject()) {
+    if (!expectingValue_) return false;
+    expectingValue_ = false;
+    return true;
+  }
+  if (nonEmptyMask_ & levelBit()) emit(',');
+  nonEmptyMask_ |= levelBit();
+  return true;
+}
+
+JsonWriter& JsonWriter::open(bool object) {
+  if (depth_ >= kMaxDepth || !beginValue()) return fail();
+  depth_++;
+  if (object) objectMask_ |= levelBit();
+  else objectMask_ &= ~levelBit();
+  nonEmptyMask_ &= ~levelBit();
+  emit(object ? '{' : '[');
+  return *this;
+}
+
+JsonWriter& JsonWriter::close(bool object) {
+  if (error_ || depth_ == 0 || inObject() != object || expectingValue_) return fail();
+  depth_--;
+  emit(object ? '}' : ']');
+  return *this;
+}
+
+JsonWriter& JsonWriter::beginObject() { return open(true); }
+JsonWriter& JsonWriter::endObject() { return close(true); }
+JsonWriter& JsonWriter::beginArray() { return open(false); }
+JsonWriter& JsonWriter::endArray() { return close(false); }
+
+JsonWriter& JsonWriter::key(const char* str, size_t length) {
+  if (error_ || !inObject() || expectingValue_) return fail();
+  if (nonEmptyMask_ & levelBit()) emit(',');
+  nonEmptyMask_ |= levelBit();
+  bytesWritten_ += printString(out_, str, length);
+  emit(':');
+  expectingValue_ = true;
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(const char* str, size_t length) {
+  if (!beginValue()) return fail();
+  bytesWritten_ += printString(out_, str, length);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(bool b) {
+  if (!beginValue()) return fail();
+  if (b) emit("true", 4);
+  else emit("false", 5);
+  return *this;
+}
+
+JsonWriter& JsonWriter::nullValue() {
+  if (!beginValue()) return fail();
+  emit("null", 4);
+  return *this;
+}
+
+JsonWriter& JsonWriter::rawValue(const char* json, size_t length) {
+  if (!beginValue()) return fail();
+  emit(json, length);
+  return *this;
+}
+
+static char* formatUnsigned(char* end, unsigned long n) {
+  do {
+    *--end = (char)('0' + n % 10);
+    n /= 10;
+  } while (n);
+  return end;
+}
+
+JsonWriter& JsonWriter::value(unsigned long n) {
+  if (!beginValue()) return fail();
+  char buf[3 * sizeof(unsigned long)];
+  char* end = buf + sizeof(buf);
+  char* start = formatUnsigned(end, n);
+  emit(start, end - start);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(long n) {
+  if (!beginValue()) return fail();
+  char buf[3 * sizeof(long) + 1];
+  char* end = buf + sizeof(buf);
+  unsigned long magnitude = n < 0 ? 0ul - (unsigned long)n : (unsigned long)n;
+  char* start = formatUnsigned(end, magnitude);
+  if (n < 0) *--start = '-';
+  emit(start, end - start);
+  return *this;
+}
+
+JsonWriter& JsonWriter::value(double n, int digits) {
+  if (isnan(n) || isinf(n)) return nullValue();
+  if (!beginValue()) return fail();
+  if (digits < 0) digits = 0;
+  if (digits > 15) digits = 15;
+
+  char buf[64];
+  char* c = buf;
+  if (n < 0.0) {
+    *c++ = '-';
+    n = -n;
+  }
+  // Beyond 32 bits the integer part no longer fits the fixed point path,
+  // so switch to d.ddde+N
+  int exponent = 0;
+  bool scientific = n >= 4294967040.0;
+  if (scientific) {
+    while (n >= 10.0) {
+      n /= 10.0;
+      exponent++;
+    }
+  }
+  double rounding = 0.5;
+  for (int i = 0; i < digits; i++) rounding /= 10.0;
+  n += rounding;
+  if (scientific && n >= 10.0) {
+    n /= 10.0;
+    exponent++;
+  }
+
+  uint32_t intPart = (uint32_t)n;
+  double remainder = n - (double)intPart;
+  char digitBuf[10];
+  char* digitEnd = digitBuf + sizeof(digitBuf);
+  char* digitStart = formatUnsigned(digitEnd, intPart);
+  while (digitStart < digitEnd) *c++ = *digitStart++;
+  if (digits > 0) {
+    *c++ = '.';
+    while (digits-- > 0) {
+      remainder *= 10.0;
+      int d = (int)remainder;
+      *c++ = (char)('0' + d);
+      remainder -= d;
+    }
+  }
+  if (scientific) {
+    *c++ = 'e';
+    *c++ = '+';
+    char* expStart = formatUnsigned(digitEnd, (unsigned long)exponent);
+    while (expStart < digitEnd) *c++ = *expStart++;
+  }
+  emit(buf, c - buf);
+  return *this;
+}
@@ -0,0 +1,126 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+/**
+  * @brief Streaming JSON writer on top of any Print.
+  *
+  *  Output goes straight to the Print; the only state is a fixed depth
+  *  nesting stack kept in two bit masks, so no memory is ever allocated.
+  *  Calls that would produce invalid JSON (a value without a key inside an
+  *  object, mismatched ends, too deep nesting, a second root value) are
+  *  ignored and latch the error flag.
+  *
+  *  @code
+  *  JsonWriter json(Serial);
+  *  json.beginObject()
+  *        .member("preset", presetName)
+  *        .key("levels").beginArray().value(-12.5).value(-3.0).endArray()
+  *      .endObject();
+  *  @endcode
+  */
+class JsonWriter
+{
+public:
+  static constexpr uint8_t kMaxDepth = 32;
+
+  JsonWriter(Print& out) : out_(out), objectMask_(0), nonEmptyMask_(0), depth_(0),
+    expectingValue_(false), rootWritten_(false), error_(false), bytesWritten_(0) {};
+
+  JsonWriter& beginObject();
+  JsonWriter& endObject();
+  JsonWriter& beginArray();
+  JsonWriter& endArray();
+
+  /**
+    * @brief Writes an object key. Must be followed by exactly one value.
+    */
+  JsonWriter& key(const char* str, size_t length);
+  JsonWriter& key(StringRef str) { return key(str, str.length()); }
+
+  JsonWriter& value(const char* str, size_t length);
+  JsonWriter& value(StringRef str) { return value(str, str.length()); }
+  JsonWriter& value(const char* str) { return value(StringRef(str)); }
+  JsonWriter& value(bool b);
+  JsonWriter& value(int n) { return value((long)n); }
+  JsonWriter& value(unsigned int n) { return value((unsigned long)n); }
+  JsonWriter& value(long n);
+  JsonWriter& value(unsigned long n);
+
+  /**
+    * @brief Writes a number with a fixed number of decimals. Values that JSON
+    *        cannot represent (nan, inf) are written as null.
+    */
+  JsonWriter& value(double n, int digits = 6);
+  JsonWriter& nullValue();
+
+  /**
+    * @brief Writes already serialized JSON as a value, without validation
+    */
+  JsonWriter& rawValue(const char* json, size_t length);
+  JsonWriter& rawValue(StringRef json) { return rawValue(json, json.length()); }
+
+  /**
+    * @brief Shorthand for key(name).value(v)
+    */
+  template<typename T>
+  JsonWriter& member(StringRef name, T v) {
+    key(name);
+    return value(v);
+  }
+
+  /**
+    * @brief Returns true once a complete root value has been written
+    */
+  bool isComplete() const { return rootWritten_ && depth_ == 0 && !error_; }
+
+  bool hasError() const { return error_; }
+
+  uint8_t depth() const { return depth_; }
+
+  size_t bytesWritten() const { return bytesWritten_; }
+
+  /**
+    * @brief Prepares the writer for a new document
+    */
+  void reset() {
+    objectMask_ = nonEmptyMask_ = 0;
+    depth_ = 0;
+    expectingValue_ = rootWritten_ = error_ = false;
+    bytesWritten_ = 0;
+  }
+
+  /**
+    * @brief Writes str as a quoted, escaped JSON string
+    */
+  static size_t printString(Print& p, const char* str, size_t length);
+
+  /**
+    * @brief Returns the index of the first character in str that needs
+    *        escaping in a JSON string, or length if there is none.
+    */
+  static size_t findEscape(const char* str, size_t length);
+
+protected:
+  Print& out_;
+  uint32_t objectMask_;
+  uint32_t nonEmptyMask_;
+  uint8_t depth_;
+  bool expectingValue_;
+  bool rootWritten_;
+  bool error_;
+  size_t bytesWritten_;
+
+  uint32_t levelBit() const { return 1u << (depth_ - 1); }
+  bool inObject() const { return depth_ > 0 && (objectMask_ & levelBit()); }
+
+  bool beginValue();
+  JsonWriter& open(bool object);
+  JsonWriter& close(bool object);
+  JsonWriter& fail() {
+    error_ = true;
+    return *this;
+  }
+  void emit(const char* str, size_t length) { bytesWritten_ += out_.write(str, length); }
+  void emit(char c) { bytesWritten_ += out_.write((uint8_t)c); }
+};
@@ -0,0 +1,148 @@
+#include "LZBlock.h"
+#include <string.h>
+
+static inline uint32_t readU32(const uint8_t* p) {
+  uint32_t v;
+  memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+static inline uint32_t hashU32(uint32_t v, uint8_t hashLog) {
+  return (v * 2654435761u) >> (32 - hashLog);
+}
+
+static inline uint8_t* writeLength(uint8_t* op, size_t len) {
+  while (len >= 255) {
+    *op++ = 255;
+    len -= 255;
+  }
+  *op++ = (uint8_t)len;
+  return op;
+}
+
+static uint8_t* writeSequence(uint8_t* op, const uint8_t* oend, const uint8_t* literals,
+  size_t literalLength, size_t offset, size_t matchLength)
+{
+  size_t needed = 1 + literalLength + literalLength / 255 + 1;
+  if (matchLength) needed += 2 + (matchLength - LZBlock::kMinMatch) / 255 + 1;
+  if ((size_t)(oend - op) < needed) return nullptr;
+
+  uint8_t* token = op++;
+  uint8_t litCode = literalLength >= 15 ? 15 : (uint8_t)literalLength;
+  if (literalLength >= 15) op = writeLength(op, literalLength - 15);
+  memcpy(op, literals, literalLength);
+  op += literalLength;
+
+  uint8_t matchCode = 0;
+  if (matchLength) {
+    *op++ = (uint8_t)offset;
+    *op++ = (uint8_t)(offset >> 8);
+    size_t code = matchLength - LZBlock::kMinMatch;
+    matchCode = code >= 15 ? 15 : (uint8_t)code;
+    if (code >= 15) op = writeLength(op, code - 15);
+  }
+  *token = (uint8_t)((litCode << 4) | matchCode);
+  return op;
+}
+
+size_t LZBlock::compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+  uint16_t* hashTable, uint8_t hashLog)
+{
+  if (srcSize > kMaxBlockSize || hashLog == 0 || hashLog > 16) return 0;
+  const uint8_t* ip = src;
+  const uint8_t* anchor = src;
+  const uint8_t* const iend = src + srcSize;
+  uint8_t* op = dst;
+  const uint8_t* const oend = dst + dstCapacity;
+
+  // LZ4 requires the last match to start 12 bytes before the end and the
+  // last 5 bytes to be literals.
+  if (srcSize >= 13) {
+    const uint8_t* const mflimit = iend - 12;
+    const uint8_t* const matchlimit = iend - 5;
+    ip++;
+    while (ip < mflimit) {
+      uint32_t seq = readU32(ip);
+      uint32_t h = hashU32(seq, hashLog);
+      const uint8_t* ref = src + hashTable[h];
+      hashTable[h] = (uint16_t)(ip - src);
+      // Stale entries from a previous block either point forward or fail the
+      // compare, so the table never needs clearing between blocks.
+      if (ref >= ip || readU32(ref) != seq) {
+        ip += 1 + ((ip - anchor) >> 6);
+        continue;
+      }
+      while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+        ip--;
+        ref--;
+      }
+      size_t len = kMinMatch;
+      while (ip + len < matchlimit && ip[len] == ref[len]) len++;
+
+      op = writeSequence(op, oend, anchor, ip - anchor, ip - ref, len);
+      if (op == nullptr) return 0;
+      ip += len;
+      anchor = ip;
+      if (ip - 2 >= src && ip < mflimit) {
+        hashTable[hashU32(readU32(ip - 2), hashLog)] = (uint16_t)(ip - 2 - src);
+      }
+    }
+  }
+
+  op = writeSequence(op, oend, anchor, iend - anchor, 0, 0);
+  if (op == nullptr) return 0;
+  return op - dst;
+}
+
+int LZBlock::decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity)
+{
+  const uint8_t* ip = src;
+  const uint8_t* const iend = src + srcSize;
+  uint8_t* op = dst;
+  uint8_t* const oend = dst + dstCapacity;
+
+  while (ip < iend) {
+    uint8_t token = *ip++;
+    size_t literalLength = token >> 4;
+    if (literalLength == 15) {
+      uint8_t b;
+      do {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        literalLength += b;
+      } while (b == 255);
+    }
+    if ((size_t)(iend - ip) < literalLength || (size_t)(oend - op) < literalLength) return -1;
+    memcpy(op, ip, literalLength);
+    ip += literalLength;
+    op += literalLength;
+    if (ip == iend) break;
+
+    if (iend - ip < 2) return -1;
+    size_t offset = ip[0] | (ip[1] << 8);
+    ip += 2;
+    if (offset == 0 || offset > (size_t)(op - dst)) return -1;
+
+    size_t matchLength = token & 15;
+    if (matchLength == 15) {
+      uint8_t b;
+      do {
+        if (ip >= iend) return -1;
+        b = *ip++;
+        matchLength += b;
+      } while (b == 255);
+    }
+    matchLength += kMinMatch;
+    if ((size_t)(oend - op) < matchLength) return -1;
+
+    const uint8_t* match = op - offset;
+    if (offset >= matchLength) {
+      memcpy(op, match, matchLength);
+      op += matchLength;
+    }
+    else {
+      while (matchLength--) *op++ = *match++;
+    }
+  }
+  return (int)(op - dst);
+}
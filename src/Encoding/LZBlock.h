@@ -0,0 +1,40 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+/**
+  * @brief LZ4 compatible block codec.
+  *
+  *  Blocks are compressed independently (the window is the block itself) so
+  *  matches never reach back further than 64KB and all state fits in a caller
+  *  supplied hash table.  Output is a plain LZ4 block and can be decoded by
+  *  the reference implementation.
+  */
+class LZBlock
+{
+public:
+  static constexpr size_t kMaxBlockSize = 65535; //!< Offsets and table entries are 16 bit
+  static constexpr size_t kMinMatch = 4;
+
+  /**
+    * @brief Compress a block
+    *
+    * @param src The data to compress
+    * @param srcSize Size of src in bytes, at most kMaxBlockSize
+    * @param dst Destination buffer
+    * @param dstCapacity Size of dst in bytes
+    * @param hashTable Table of (1 << hashLog) entries, must be zeroed before first use
+    * @param hashLog Log2 of the hash table size
+    * @return size_t The compressed size, or 0 if it does not fit in dstCapacity
+    */
+  static size_t compress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity,
+    uint16_t* hashTable, uint8_t hashLog);
+
+  /**
+    * @brief Decompress a block, validating every length and offset
+    *
+    * @return int The decompressed size, or -1 if the block is malformed or
+    *         does not fit in dstCapacity
+    */
+  static int decompress(const uint8_t* src, size_t srcSize, uint8_t* dst, size_t dstCapacity);
+};
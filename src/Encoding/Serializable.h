@@ -0,0 +1,56 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+class BinaryWriter;
+class BinaryReader;
+
+/**
+  * @brief The binary counterpart of Printable.
+  *
+  *  A class implementing both Printable and Serializable can be sent as text
+  *  with Print::print() or as a compact binary message with
+  *  BinaryWriter::writeMessage(), from the same object.
+  *
+  *  @code
+  *  struct MeterReading : public Printable, public Serializable {
+  *    uint8_t channel;
+  *    float level;
+  *
+  *    size_t printTo(Print& p) const override {
+  *      return p.print(channel) + p.print(": ") + p.print(level);
+  *    }
+  *    size_t serializeTo(BinaryWriter& w) const override {
+  *      return w.writeVarint(channel) + w.writeFloat(level);
+  *    }
+  *    bool deserializeFrom(BinaryReader& r) override {
+  *      return r.readVarint(channel) && r.readFloat(level);
+  *    }
+  *    uint32_t schemaId() const override { return 7; }
+  *  };
+  *  @endcode
+  */
+class Serializable
+{
+  public:
+    /**
+      * @brief Writes the object's fields
+      *
+      * @return size_t The number of bytes written
+      */
+    virtual size_t serializeTo(BinaryWriter& w) const = 0;
+
+    /**
+      * @brief Reads the fields written by serializeTo(). Types that are
+      *        only ever sent need not implement it.
+      *
+      * @return false If the input was truncated or invalid
+      */
+    virtual bool deserializeFrom(BinaryReader&) { return false; }
+
+    /**
+      * @brief Identifies the message layout when written with
+      *        BinaryWriter::writeMessage(). Zero means no schema.
+      */
+    virtual uint32_t schemaId() const { return 0; }
+};
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "./EncodingDeps.h"
+
+/*
+  Vector kernels are only built for x86 with GCC or Clang, where individual
+  functions can be compiled for an instruction set above the baseline and
+  selected at runtime.  Everywhere else (MCUs, MSVC) the scalar paths are used.
+  Define RT_CORE_DISABLE_SIMD to force the scalar paths.
+*/
+#if !defined(RT_CORE_DISABLE_SIMD) && (defined(__x86_64__) || defined(__i386__)) \
+  && (defined(__GNUC__) || defined(__clang__))
+#define RT_SIMD_X86 1
+#define RT_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define RT_TARGET_AVX2 __attribute__((target("avx2")))
+#include <immintrin.h>
+#else
+#define RT_SIMD_X86 0
+#endif
+
+/**
+  * @brief Runtime detection of the vector extensions used by the encoders.
+  *        Results are cached after the first query.
+  */
+class SimdSupport
+{
+public:
+  static bool hasSSE2() {
+#if RT_SIMD_X86
+    static const bool has = __builtin_cpu_supports("sse2");
+    return has;
+#else
+    return false;
+#endif
+  }
+
+  static bool hasSSSE3() {
+#if RT_SIMD_X86
+    static const bool has = __builtin_cpu_supports("ssse3");
+    return has;
+#else
+    return false;
+#endif
+  }
+
+  static bool hasAVX2() {
+#if RT_SIMD_X86
+    static const bool has = __builtin_cpu_supports("avx2");
+    return has;
+#else
+    return false;
+#endif
+  }
+};
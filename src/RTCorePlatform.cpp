@@ -2,35 +2,60 @@
 
 #include "RTCorePlatform.h"
 
+// Converts a tick count at freq Hz to nanoseconds without overflowing the
+// intermediate product.
+static inline uint64_t ticksToNanos(uint64_t ticks, uint64_t freq) {
+  return (ticks / freq) * 1000000000ull + ((ticks % freq) * 1000000000ull) / freq;
+}
+
+#if RT_SIMULATED_CLOCK
+#define RT_SIMULATED_NANOS() \
+  if (SimulatedClock* sim = SimulatedClock::current()) return sim->nanos()
+#define RT_SIMULATED_DELAY(ns) \
+  if (SimulatedClock* sim = SimulatedClock::current()) { sim->advanceNanos(ns); return; }
+#else
+#define RT_SIMULATED_NANOS()
+#define RT_SIMULATED_DELAY(ns)
+#endif
+
 #if JUCE_MODULE_AVAILABLE_juce_core
 
 #include <JuceHeader.h>
 
 extern "C" {
+  uint64_t realNanos() {
+    static const uint64_t freq = (uint64_t)juce::Time::getHighResolutionTicksPerSecond();
+    return ticksToNanos((uint64_t)juce::Time::getHighResolutionTicks(), freq);
+  }
+
+  uint64_t nanos() {
+    RT_SIMULATED_NANOS();
+    return realNanos();
+  }
+
+  uint64_t micros64() {
+    return nanos() / 1000ull;
+  }
+
+  uint64_t millis64() {
+    return nanos() / 1000000ull;
+  }
+
   uint32_t millis() {
-    int64_t hrTicks = juce::Time::getHighResolutionTicks();
-    double secs = juce::Time::highResolutionTicksToSeconds(hrTicks);
-    double ms = secs * 1000.f;
-    return (uint32_t)ms;
+    return (uint32_t)millis64();
   }
 
   uint32_t micros() {
-    int64_t hrTicks = juce::Time::getHighResolutionTicks();
-    double secs = juce::Time::highResolutionTicksToSeconds(hrTicks);
-    double us = secs * 1000000.;
-    return (uint32_t)us;
+    return (uint32_t)micros64();
   }
 
   void delay(uint32_t ms) {
+    RT_SIMULATED_DELAY((uint64_t)ms * 1000000ull);
     juce::Thread::sleep(ms);
   }
 
   void delayMicroseconds(uint32_t us) {
-    if (us <= 1000.f) {
-      delay(1);
-    } else {
-      delay(us / 1000.f);
-    }
+    PreciseDelay::delayMicros(us);
   }
 }
 
@@ -39,47 +64,138 @@ extern "C" {
 #include <Windows.h>
 
 extern "C" {
-  void get_micros_uli(ULARGE_INTEGER& uli)
-  {
-    SYSTEMTIME st;
-    GetSystemTime(&st);
-    FILETIME ft;
-    SystemTimeToFileTime(&st, &ft);
-    uli.HighPart = ft.dwHighDateTime;
-    uli.LowPart = ft.dwLowDateTime;
-  }
-
-  uint64_t get_micros_ull()
-  {
-    ULARGE_INTEGER uli;
-    get_micros_uli(uli);
-    return (uint64_t)(uli.QuadPart / 10ull);
+  uint64_t realNanos() {
+    static uint64_t freq = 0;
+    if (freq == 0) {
+      LARGE_INTEGER f;
+      QueryPerformanceFrequency(&f);
+      freq = (uint64_t)f.QuadPart;
+    }
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    return ticksToNanos((uint64_t)counter.QuadPart, freq);
+  }
+
+  uint64_t nanos() {
+    RT_SIMULATED_NANOS();
+    return realNanos();
   }
+
+  uint64_t micros64() {
+    return nanos() / 1000ull;
+  }
+
+  uint64_t millis64() {
+    return nanos() / 1000000ull;
+  }
+
   uint32_t millis() {
-    auto us_ull = get_micros_ull();
-    auto ms_ull = us_ull / 1000ull;
-    return (uint32_t)ms_ull;
+    return (uint32_t)millis64();
   }
 
   uint32_t micros() {
-    return (uint32_t)(get_micros_ull);
+    return (uint32_t)micros64();
   }
 
   void delay(uint32_t ms) {
+    RT_SIMULATED_DELAY((uint64_t)ms * 1000000ull);
     Sleep(ms);
   }
 
   void delayMicroseconds(uint32_t us) {
-    if (us <= 1000.f) {
-      delay(1);
-    }
-    else {
-      delay(us / 1000.f);
-    }
+    PreciseDelay::delayMicros(us);
+  }
+}
+
+#elif defined(__unix__) || defined(__APPLE__)
+
+#include <time.h>
+#include <errno.h>
+
+// CLOCK_MONOTONIC is served from the vDSO on Linux, so reading it does not
+// enter the kernel.
+static inline uint64_t monotonicNanos() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleepNanos(uint64_t ns) {
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ns / 1000000000ull);
+  ts.tv_nsec = (long)(ns % 1000000000ull);
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+}
+
+extern "C" {
+  uint64_t realNanos() {
+    return monotonicNanos();
+  }
+
+  uint64_t nanos() {
+    RT_SIMULATED_NANOS();
+    return monotonicNanos();
+  }
+
+  uint64_t micros64() {
+    return nanos() / 1000ull;
+  }
+
+  uint64_t millis64() {
+    return nanos() / 1000000ull;
+  }
+
+  uint32_t millis() {
+    return (uint32_t)millis64();
+  }
+
+  uint32_t micros() {
+    return (uint32_t)micros64();
+  }
+
+  void delay(uint32_t ms) {
+    RT_SIMULATED_DELAY((uint64_t)ms * 1000000ull);
+    sleepNanos((uint64_t)ms * 1000000ull);
+  }
+
+  void delayMicroseconds(uint32_t us) {
+    PreciseDelay::delayMicros(us);
+  }
+}
+
+#elif RT_HAS_ARDUINO
+
+// Extends the 32 bit Arduino counters. Each must be read at least once per
+// wrap period (~49 days for millis(), ~71 minutes for micros()).
+extern "C" {
+  uint64_t millis64() {
+    static uint32_t last = 0;
+    static uint32_t high = 0;
+    uint32_t now = millis();
+    if (now < last) high++;
+    last = now;
+    return ((uint64_t)high << 32) | now;
+  }
+
+  uint64_t micros64() {
+    static uint32_t last = 0;
+    static uint32_t high = 0;
+    uint32_t now = micros();
+    if (now < last) high++;
+    last = now;
+    return ((uint64_t)high << 32) | now;
+  }
+
+  uint64_t nanos() {
+    return micros64() * 1000ull;
+  }
+
+  uint64_t realNanos() {
+    return nanos();
   }
 }
 
 #endif
 
 
-#endif
\ No newline at end of file
+#endif
@@ -4,10 +4,43 @@
 #include "./RTCorePlatformDeps.h"
 //STRINGS 
 #include "./Strings/StringRef.h"
+#include "./Strings/StringSpan.h"
 #include "./Strings/StringBuffer.h"
 #include "./Strings/FixedString.h"
 #include "./Strings/StaticString.h"
+#include "./Strings/StringArena.h"
+#include "./Strings/SmallString.h"
+#include "./Strings/StringRope.h"
+#include "./Strings/PublishedString.h"
+#include "./Strings/RingString.h"
+//ENCODING
+#include "./Encoding/LZBlock.h"
+#include "./Encoding/CompressingPrint.h"
+#include "./Encoding/Hex.h"
+#include "./Encoding/Base64.h"
+#include "./Encoding/JsonWriter.h"
+#include "./Encoding/JsonParser.h"
+#include "./Encoding/Serializable.h"
+#include "./Encoding/BinaryWriter.h"
+#include "./Encoding/BinaryReader.h"
 
+//TIME
+#include "./Time/Clocks.h"
+#include "./Time/CycleClock.h"
+#include "./Time/FrameClock.h"
+#include "./Time/PreciseDelay.h"
 #include "./BasicTimer.h"
+#include "./Time/TimerWheel.h"
+#include "./Time/SimulatedClock.h"
+#include "./Time/TimerService.h"
+#include "./Time/CoScheduler.h"
+#include "./Time/PeriodicTimer.h"
+#include "./Time/RateLimiter.h"
+#include "./Time/RateLimitedPrint.h"
+
+//DIAGNOSTICS
+#include "./Diagnostics/LatencyHistogram.h"
+#include "./Diagnostics/Profiler.h"
+#include "./Diagnostics/LoopWatchdog.h"
 
 #endif
@@ -22,4 +22,21 @@ extern "C" {
 #include "./Deps/Printable.h"
 #endif
 
+/*
+  Wide timebase.  millis() and micros() wrap after ~49 days and ~71 minutes,
+  these do not (in practice).  nanos() is the finest the platform offers, the
+  value is always in nanoseconds.  realNanos() reads the same timebase but
+  ignores an installed SimulatedClock, for measuring the machine itself.
+*/
+#ifdef __cplusplus
+extern "C" {
+#endif
+  uint64_t millis64();
+  uint64_t micros64();
+  uint64_t nanos();
+  uint64_t realNanos();
+#ifdef __cplusplus
+}
+#endif
+
 #endif
\ No newline at end of file
@@ -4,16 +4,13 @@
 #include <ctype.h>
 
 size_t FixedString::write(const uint8_t* buffer, size_t size) {
-  size_t cap = remainingCapacity();
+  int room = remainingCapacity();
+  if (room <= 0) return 0;
+  size_t cap = room;
   size_t toCopy = cap > size ? size : cap;
-  size_t didCopy = toCopy;
-  int index = index_;
-  while (toCopy--) {
-    char c = (char)(*buffer++);
-    buffer_[index++] = c;
-  }
-  setIndex(index);
-  return didCopy;
+  memcpy(getCurrentPtr(), buffer, toCopy);
+  setIndex(index_ + toCopy);
+  return toCopy;
 }
 
 
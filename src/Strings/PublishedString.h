@@ -0,0 +1,173 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+#include "./StringSpan.h"
+#include "./FixedString.h"
+#include <atomic>
+
+/**
+  * @brief Text published by one thread and read by any number of others
+  *        without locks.
+  *
+  *  Meant for status text that a real-time thread updates (preset name,
+  *  meter readouts) and UI or telemetry threads show.  publish() is wait
+  *  free: it never waits for a reader, so it cannot be held up by a
+  *  descheduled UI thread the way a mutex would hold it up.
+  *
+  *  There are two copies of the text and a sequence number on each (a
+  *  seqlock).  The writer fills the copy readers are not directed to, then
+  *  points them at it.  A reader copies the current text and checks the
+  *  sequence number afterwards; it retries only if the writer published
+  *  twice during the copy, so readers almost never retry and never block
+  *  the writer.
+  *
+  *  The text is held in atomic words, so the copies are race free without
+  *  a lock.  There must be only one writer at a time.
+  *
+  * @code
+  * PublishedString<48> presetName;
+  *
+  * // audio thread
+  * presetName.publish(preset.name());
+  *
+  * // UI thread
+  * StaticString<49> shown;
+  * uint32_t shownVersion = 0;
+  * if (presetName.readIfChanged(shown, shownVersion)) redraw(shown);
+  * @endcode
+  *
+  * @tparam N The maximum length; longer text is truncated
+  */
+template<size_t N>
+class PublishedString {
+  static_assert(N > 0, "N must be greater than zero");
+  public:
+    static constexpr size_t kCapacity = N;
+
+    PublishedString(): version_(0) {
+      for (Slot& slot : slots_) {
+        slot.sequence.store(0, std::memory_order_relaxed);
+        slot.version.store(0, std::memory_order_relaxed);
+        slot.length.store(0, std::memory_order_relaxed);
+      }
+    }
+
+    PublishedString(const PublishedString&) = delete;
+    PublishedString& operator=(const PublishedString&) = delete;
+
+    /**
+      * @brief Replaces the text; wait free, single writer only
+      *
+      * @return size_t The characters published, at most N
+      */
+    size_t publish(StringSpan text) {
+      size_t length = text.length() < N ? text.length() : N;
+      uint32_t next = version_.load(std::memory_order_relaxed) + 1;
+      Slot& slot = slots_[next & 1];
+      uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+      slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+      std::atomic_thread_fence(std::memory_order_release);
+      const char* data = text.data();
+      for (size_t i = 0; i * 4 < length; i++) {
+        uint32_t word = 0;
+        size_t count = length - i * 4 < 4 ? length - i * 4 : 4;
+        memcpy(&word, data + i * 4, count);
+        slot.words[i].store(word, std::memory_order_relaxed);
+      }
+      slot.version.store(next, std::memory_order_relaxed);
+      slot.length.store((uint32_t)length, std::memory_order_relaxed);
+      slot.sequence.store(sequence + 2, std::memory_order_release);
+      version_.store(next, std::memory_order_release);
+      return length;
+    }
+
+    size_t publish(StringRef text) {
+      return publish(StringSpan(text));
+    }
+
+    size_t publish(const char* text) {
+      return publish(StringSpan(text));
+    }
+
+    /**
+      * @brief Counts publications; changes whenever the text may have
+      */
+    uint32_t version() const {
+      return version_.load(std::memory_order_acquire);
+    }
+
+    /**
+      * @brief Copies a consistent snapshot into buffer, null terminated
+      *
+      * @param version Set to the version of the snapshot, if not nullptr
+      * @return size_t The length copied, truncated to size - 1
+      */
+    size_t read(char* buffer, size_t size, uint32_t* version = nullptr) const {
+      if (buffer == nullptr || size == 0) return 0;
+      char snapshot[kWords * 4];
+      uint32_t snapshotVersion;
+      size_t length = readSnapshot(snapshot, snapshotVersion);
+      if (version != nullptr) *version = snapshotVersion;
+      if (length > size - 1) length = size - 1;
+      memcpy(buffer, snapshot, length);
+      buffer[length] = '\0';
+      return length;
+    }
+
+    /**
+      * @brief Replaces out's contents with a consistent snapshot
+      *
+      * @return size_t The length copied, truncated to out's capacity
+      */
+    size_t read(FixedString& out, uint32_t* version = nullptr) const {
+      char snapshot[kWords * 4];
+      uint32_t snapshotVersion;
+      size_t length = readSnapshot(snapshot, snapshotVersion);
+      if (version != nullptr) *version = snapshotVersion;
+      out.reset();
+      return out.write((const uint8_t*)snapshot, length);
+    }
+
+    /**
+      * @brief Reads into out only if the text was published since lastVersion,
+      *        which is then updated; for polling from a UI loop
+      */
+    bool readIfChanged(FixedString& out, uint32_t& lastVersion) const {
+      if (version() == lastVersion) return false;
+      read(out, &lastVersion);
+      return true;
+    }
+
+  protected:
+    static constexpr size_t kWords = (N + 3) / 4;
+
+    struct Slot {
+      std::atomic<uint32_t> sequence; //!< Odd while the writer fills the slot
+      std::atomic<uint32_t> version;
+      std::atomic<uint32_t> length;
+      std::atomic<uint32_t> words[kWords];
+    };
+
+    Slot slots_[2];
+    std::atomic<uint32_t> version_; //!< Publications so far; the low bit names the current slot
+
+    size_t readSnapshot(char* snapshot, uint32_t& version) const {
+      for (;;) {
+        const Slot& slot = slots_[version_.load(std::memory_order_acquire) & 1];
+        uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+        if (sequence & 1) continue;
+        // The writer may have refilled the slot since version_ was read, so
+        // take the version that goes with the text from the slot
+        version = slot.version.load(std::memory_order_relaxed);
+        size_t length = slot.length.load(std::memory_order_relaxed);
+        if (length > N) length = N;
+        for (size_t i = 0; i * 4 < length; i++) {
+          uint32_t word = slot.words[i].load(std::memory_order_relaxed);
+          memcpy(snapshot + i * 4, &word, 4);
+        }
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (slot.sequence.load(std::memory_order_relaxed) == sequence) return length;
+      }
+    }
+};
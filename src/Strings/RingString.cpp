@@ -0,0 +1,114 @@
+#include "RingString.h"
+
+static constexpr uint32_t kRingStringMagic = 0x52494e47; // "RING"
+
+RingString::RingString(char* storage, size_t size, bool recover) :
+  state_(nullptr), data_(nullptr), capacity_(0), recovered_(false) {
+  if (storage == nullptr || size <= sizeof(State) || ((uintptr_t)storage & 3) != 0) return;
+  state_ = (State*)storage;
+  data_ = storage + sizeof(State);
+  capacity_ = size - sizeof(State);
+  if (capacity_ > UINT32_MAX) capacity_ = UINT32_MAX;
+  recovered_ = recover && state_->magic == kRingStringMagic && state_->capacity == capacity_
+    && state_->start < capacity_ && state_->length <= capacity_ && state_->check == checkOf(*state_);
+  if (!recovered_) clear();
+}
+
+uint32_t RingString::checkOf(const State& state) {
+  uint32_t check = state.magic;
+  const uint32_t fields[] = { state.capacity, state.start, state.length, state.dropped };
+  for (uint32_t field : fields) check = ((check << 5) | (check >> 27)) ^ field;
+  return ~check;
+}
+
+void RingString::clear() {
+  if (state_ == nullptr) return;
+  state_->magic = kRingStringMagic;
+  state_->capacity = (uint32_t)capacity_;
+  state_->start = 0;
+  state_->length = 0;
+  state_->dropped = 0;
+  commit();
+}
+
+size_t RingString::write(uint8_t c) {
+  return write(&c, 1);
+}
+
+size_t RingString::write(const uint8_t* buffer, size_t size) {
+  if (state_ == nullptr || size == 0) return 0;
+  size_t written = size;
+  uint32_t dropped = 0;
+  if (size >= capacity_) {
+    // Only the newest capacity bytes survive
+    dropped = (uint32_t)(state_->length + size - capacity_);
+    memcpy(data_, buffer + size - capacity_, capacity_);
+    state_->start = 0;
+    state_->length = (uint32_t)capacity_;
+  }
+  else {
+    size_t end = state_->start + state_->length;
+    if (end >= capacity_) end -= capacity_;
+    size_t first = capacity_ - end < size ? capacity_ - end : size;
+    memcpy(data_ + end, buffer, first);
+    memcpy(data_, buffer + first, size - first);
+    size_t length = state_->length + size;
+    if (length > capacity_) {
+      dropped = (uint32_t)(length - capacity_);
+      size_t start = state_->start + dropped;
+      if (start >= capacity_) start -= capacity_;
+      state_->start = (uint32_t)start;
+      length = capacity_;
+    }
+    state_->length = (uint32_t)length;
+  }
+  state_->dropped += dropped;
+  commit();
+  return written;
+}
+
+void RingString::segments(StringSpan& first, StringSpan& second) const {
+  if (state_ == nullptr) {
+    first = StringSpan();
+    second = StringSpan();
+    return;
+  }
+  size_t start = state_->start;
+  size_t length = state_->length;
+  size_t head = capacity_ - start < length ? capacity_ - start : length;
+  first = StringSpan(data_ + start, head);
+  second = StringSpan(data_, length - head);
+}
+
+void RingString::lines(StringSpan& first, StringSpan& second) const {
+  segments(first, second);
+  if (droppedBytes() == 0) return;
+  int newline = first.indexOf('\n');
+  if (newline >= 0) {
+    first = first.subSpan((size_t)newline + 1);
+    return;
+  }
+  newline = second.indexOf('\n');
+  first = StringSpan();
+  second = newline >= 0 ? second.subSpan((size_t)newline + 1) : StringSpan();
+}
+
+size_t RingString::copyTo(char* buffer, size_t size, bool wholeLines) const {
+  if (buffer == nullptr || size == 0) return 0;
+  StringSpan first, second;
+  if (wholeLines) lines(first, second);
+  else segments(first, second);
+  size_t copied = first.length() < size - 1 ? first.length() : size - 1;
+  memcpy(buffer, first.data(), copied);
+  size_t more = second.length() < size - 1 - copied ? second.length() : size - 1 - copied;
+  memcpy(buffer + copied, second.data(), more);
+  copied += more;
+  buffer[copied] = '\0';
+  return copied;
+}
+
+size_t RingString::printTo(Print& p) const {
+  StringSpan first, second;
+  lines(first, second);
+  return first.printTo(p) + second.printTo(p);
+}
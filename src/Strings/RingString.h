@@ -0,0 +1,166 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+#include "./StringSpan.h"
+
+/*
+  RT_NOINIT places a variable where the C runtime neither zeroes nor
+  initializes it, so its contents survive a warm reset (watchdog, fault
+  handler, reset button).  The .noinit section exists in the usual AVR and
+  ARM GCC linker scripts; define RT_NOINIT before including this header to
+  name another section, e.g. ESP32's RTC_NOINIT_ATTR.  On hosts it is empty.
+*/
+#ifndef RT_NOINIT
+#if defined(RT_HAS_ARDUINO) && defined(__GNUC__)
+#define RT_NOINIT __attribute__((section(".noinit")))
+#else
+#define RT_NOINIT
+#endif
+#endif
+
+/**
+  * @brief A Print that keeps the last bytes written to it, overwriting the
+  *        oldest ones once full.
+  *
+  *  For crash diagnostics: print the log into it as well as (or instead of)
+  *  the serial port, and dump it after a fault.  Writing is one or two
+  *  memcpy()s, never a scan, and never fails.
+  *
+  *  The text is read without copying as at most two StringSpans, the older
+  *  part first (StringSpan rather than StringRef, as the parts are not null
+  *  terminated).  Once the oldest bytes have been overwritten the first line
+  *  is usually cut, so lines() drops everything up to the first newline.
+  *
+  *  The position and length are kept with the text in the caller's memory,
+  *  with a check word.  Constructed with recover set, a RingString over
+  *  memory that survived a warm reset keeps what it finds there when the
+  *  check word matches, and starts empty otherwise (after power up).  A
+  *  RingString is for one thread.
+  *
+  * @code
+  * RT_NOINIT static StaticRingString<8192> crashLog(true);
+  *
+  * void setup() {
+  *   if (crashLog.wasRecovered()) Serial.print(crashLog);   // the last run's log
+  *   crashLog.clear();
+  * }
+  * @endcode
+  */
+class RingString : public Print, public Printable {
+  public:
+    /**
+      * @param storage Memory for the text and a small header, aligned for
+      *        uint32_t
+      * @param recover Keep the text already in storage if its header is
+      *        intact
+      */
+    RingString(char* storage, size_t size, bool recover = false);
+
+    RingString(const RingString&) = delete;
+    RingString& operator=(const RingString&) = delete;
+
+    using Print::write;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    /**
+      * @brief Never blocks; reports the capacity, at most 0x7fff
+      */
+    int availableForWrite() override {
+      return capacity_ > 0x7fff ? 0x7fff : (int)capacity_;
+    }
+
+    void clear();
+
+    size_t capacity() const {
+      return capacity_;
+    }
+
+    size_t length() const {
+      return state_ != nullptr ? state_->length : 0;
+    }
+
+    bool isEmpty() const {
+      return length() == 0;
+    }
+
+    /**
+      * @brief Bytes overwritten since the ring was cleared; the count wraps
+      *        at 2^32
+      */
+    uint32_t droppedBytes() const {
+      return state_ != nullptr ? state_->dropped : 0;
+    }
+
+    /**
+      * @brief True if the constructor kept text found in its memory
+      */
+    bool wasRecovered() const {
+      return recovered_;
+    }
+
+    /**
+      * @brief The text as up to two parts, oldest first; second is empty
+      *        unless the text wraps around the end of the buffer
+      */
+    void segments(StringSpan& first, StringSpan& second) const;
+
+    /**
+      * @brief Like segments(), but once bytes have been dropped the text
+      *        starts after the first newline, so it begins with a whole line
+      */
+    void lines(StringSpan& first, StringSpan& second) const;
+
+    /**
+      * @brief Copies the text into buffer, null terminated
+      *
+      * @param wholeLines Read through lines() instead of segments()
+      * @return size_t Characters copied; the newest are dropped if buffer
+      *         is too small
+      */
+    size_t copyTo(char* buffer, size_t size, bool wholeLines = true) const;
+
+    /**
+      * @brief Writes the text to p, starting at a whole line
+      */
+    size_t printTo(Print& p) const override;
+
+  protected:
+    struct State {
+      uint32_t magic;
+      uint32_t capacity;
+      uint32_t start;
+      uint32_t length;
+      uint32_t dropped;
+      uint32_t check;
+    };
+
+    State* state_;
+    char* data_;
+    size_t capacity_;
+    bool recovered_;
+
+    static uint32_t checkOf(const State& state);
+
+    void commit() {
+      state_->check = checkOf(*state_);
+    }
+};
+
+/**
+  * @brief A RingString that owns its memory; place it with RT_NOINIT to
+  *        keep the text across a warm reset
+  *
+  * @tparam N Bytes of text kept; rounded up to a multiple of 4
+  */
+template<size_t N>
+class StaticRingString : public RingString {
+  static_assert(N > 0, "N must be greater than zero");
+  static_assert(N <= UINT32_MAX, "N must fit in 32 bits");
+  public:
+    StaticRingString(bool recover = false): RingString((char*)sstorage_, sizeof(sstorage_), recover){};
+  protected:
+    uint32_t sstorage_[(sizeof(State) + N + 3) / 4];
+};
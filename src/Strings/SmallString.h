@@ -0,0 +1,425 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+#include "./StringSpan.h"
+#include "./StringArena.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+  Allocators for SmallString.  An allocator is a small copyable object with
+
+    char* allocate(size_t size);
+    char* reallocate(char* block, size_t oldSize, size_t newSize);
+    void deallocate(char* block, size_t size);
+
+  where allocate() and reallocate() return nullptr when out of memory, and
+  reallocate() keeps the first oldSize bytes.
+
+  Define RT_STRINGS_NO_HEAP to make TruncatingStringAllocator the default, so
+  that only strings that name another allocator can grow.
+*/
+
+/**
+  * @brief malloc / realloc / free
+  */
+struct HeapStringAllocator {
+  char* allocate(size_t size) {
+    return (char*)malloc(size);
+  }
+
+  char* reallocate(char* block, size_t oldSize, size_t newSize) {
+    (void)oldSize;
+    return (char*)realloc(block, newSize);
+  }
+
+  void deallocate(char* block, size_t size) {
+    (void)size;
+    free(block);
+  }
+};
+
+/**
+  * @brief Never allocates: a SmallString using it keeps to its inline
+  *        storage and truncates like FixedString, for real-time threads
+  */
+struct TruncatingStringAllocator {
+  char* allocate(size_t) {
+    return nullptr;
+  }
+
+  char* reallocate(char*, size_t, size_t) {
+    return nullptr;
+  }
+
+  void deallocate(char*, size_t) {}
+};
+
+/**
+  * @brief Allocates from a StringArena; the memory comes back when the arena
+  *        or scope is released, not when the string is destroyed
+  */
+class ArenaStringAllocator {
+  public:
+    ArenaStringAllocator(StringArena& arena): arena_(&arena){};
+
+    char* allocate(size_t size) {
+      return arena_->allocate(size);
+    }
+
+    char* reallocate(char* block, size_t oldSize, size_t newSize) {
+      return arena_->reallocate(block, oldSize, newSize);
+    }
+
+    void deallocate(char*, size_t) {}
+
+  protected:
+    StringArena* arena_;
+};
+
+#if RT_STRINGS_NO_HEAP
+typedef TruncatingStringAllocator DefaultStringAllocator;
+#else
+typedef HeapStringAllocator DefaultStringAllocator;
+#endif
+
+/**
+  * @brief A growable string that keeps up to N characters inline and moves
+  *        to memory from its allocator when it outgrows them.
+  *
+  *  Like FixedString it is a Print and converts to StringRef, and it is
+  *  always null terminated.  It tracks its length, so appending does not
+  *  scan the string.  Capacity grows geometrically, so appending n
+  *  characters one at a time costs O(n) copies.  Moving a string that has
+  *  left its inline storage takes its buffer instead of copying.
+  *
+  *  When the allocator is out of memory, or is TruncatingStringAllocator,
+  *  writes are truncated at the capacity and the write error is set, which
+  *  matches FixedString with an error report added.
+  *
+  * @code
+  * SmallString<32> path;                                  // heap when longer than 32
+  * SmallString<64, ArenaStringAllocator> line(arena);     // arena when longer than 64
+  * SmallString<64, TruncatingStringAllocator> rtLine;     // never allocates
+  * @endcode
+  *
+  * @tparam N Characters held inline, not counting the terminator
+  * @tparam Alloc The allocator used beyond N characters
+  */
+template<size_t N, typename Alloc = DefaultStringAllocator>
+class SmallString: public Print {
+  static_assert(N > 0, "N must be greater than zero");
+  public:
+    static constexpr size_t kInlineCapacity = N;
+
+    SmallString(Alloc alloc = Alloc()):
+      data_(inline_), length_(0), capacity_(N), alloc_(alloc){
+      inline_[0] = '\0';
+    };
+
+    SmallString(StringSpan str, Alloc alloc = Alloc()): SmallString(alloc) {
+      append(str);
+    };
+
+    SmallString(const SmallString& other): SmallString(other.alloc_) {
+      append(other.span());
+    };
+
+    /**
+      * @brief Takes other's buffer if it has left its inline storage, else
+      *        copies; other is left empty
+      */
+    SmallString(SmallString&& other): SmallString(other.alloc_) {
+      take(other);
+    };
+
+    ~SmallString() {
+      release();
+    }
+
+    SmallString& operator=(const SmallString& other) {
+      if (this != &other) {
+        clear();
+        append(other.span());
+      }
+      return *this;
+    }
+
+    SmallString& operator=(SmallString&& other) {
+      if (this != &other) {
+        release();
+        alloc_ = other.alloc_;
+        take(other);
+      }
+      return *this;
+    }
+
+    SmallString& operator=(StringSpan str) {
+      clear();
+      append(str);
+      return *this;
+    }
+
+    size_t length() const {
+      return length_;
+    }
+
+    size_t capacity() const {
+      return capacity_;
+    }
+
+    bool isEmpty() const {
+      return length_ == 0;
+    }
+
+    /**
+      * @brief True while the characters are in the inline storage
+      */
+    bool isInline() const {
+      return data_ == inline_;
+    }
+
+    const char* c_str() const {
+      return data_;
+    }
+
+    char* data() {
+      return data_;
+    }
+
+    StringSpan span() const {
+      return StringSpan(data_, length_);
+    }
+
+    operator StringRef() const {
+      return StringRef(data_);
+    }
+
+    operator StringSpan() const {
+      return span();
+    }
+
+    /**
+      * @brief Makes room for capacity characters in total
+      *
+      * @return false If the allocator could not provide it
+      */
+    bool reserve(size_t capacity) {
+      if (capacity <= capacity_) return true;
+      size_t grown = capacity_ * 2;
+      if (grown < capacity || grown < capacity_) grown = capacity;
+      if (growTo(grown)) return true;
+      return grown != capacity && growTo(capacity);
+    }
+
+    /**
+      * @brief Empties the string, keeping its capacity
+      */
+    void clear() {
+      length_ = 0;
+      data_[0] = '\0';
+    }
+
+    void reset() {
+      clear();
+    }
+
+    void truncate(size_t newLength) {
+      if (newLength < length_) {
+        length_ = newLength;
+        data_[length_] = '\0';
+      }
+    }
+
+    size_t append(StringSpan str) {
+      return write((const uint8_t*)str.data(), str.length());
+    }
+
+    size_t append(StringRef str) {
+      return append(StringSpan(str));
+    }
+
+    size_t append(const char* str) {
+      return append(StringSpan(str));
+    }
+
+    size_t append(char c) {
+      return write((uint8_t)c);
+    }
+
+    size_t append(int number, int radix = 10) {
+      return print(number, radix);
+    }
+
+    using Print::write;
+
+    size_t write(uint8_t c) override {
+      if (length_ == capacity_ && !reserve(length_ + 1)) {
+        setWriteError();
+        return 0;
+      }
+      data_[length_++] = (char)c;
+      data_[length_] = '\0';
+      return 1;
+    }
+
+    size_t write(const uint8_t* buffer, size_t size) override {
+      if (size > capacity_ - length_ && !reserve(length_ + size)) {
+        setWriteError();
+        size = capacity_ - length_;
+      }
+      memcpy(data_ + length_, buffer, size);
+      length_ += size;
+      data_[length_] = '\0';
+      return size;
+    }
+
+    int availableForWrite() override {
+      size_t room = capacity_ - length_;
+      return room > 0x7fff ? 0x7fff : (int)room;
+    }
+
+    /**
+      * @brief Appends printf formatted text, growing to fit it
+      *
+      * @return size_t The number of characters appended
+      */
+    size_t printf(const char* format, ...) {
+      va_list args;
+      va_start(args, format);
+      va_list retry;
+      va_copy(retry, args);
+      size_t room = capacity_ - length_;
+      int n = vsnprintf(data_ + length_, room + 1, format, args);
+      va_end(args);
+      if (n < 0) {
+        va_end(retry);
+        data_[length_] = '\0';
+        return 0;
+      }
+      size_t size = (size_t)n;
+      if (size > room) {
+        if (reserve(length_ + size)) vsnprintf(data_ + length_, size + 1, format, retry);
+        else {
+          setWriteError();
+          size = room;
+        }
+      }
+      va_end(retry);
+      length_ += size;
+      data_[length_] = '\0';
+      return size;
+    }
+
+    char charAt(size_t loc) const {
+      return loc < length_ ? data_[loc] : '\0';
+    }
+
+    char operator[](size_t index) const {
+      return charAt(index);
+    }
+
+    int compareWith(const StringRef other) const {
+      return StringRef::compare(*this, other);
+    }
+
+    bool equalsIgnoreCase(StringRef s) const {
+      return StringRef(*this).equalsIgnoreCase(s);
+    }
+
+    bool startsWith(StringRef prefix) const {
+      return StringRef(*this).startsWith(prefix);
+    }
+
+    bool endsWith(StringRef suffix) const {
+      return StringRef(*this).endsWith(suffix);
+    }
+
+    int indexOf(char ch, size_t fromIndex = 0) const {
+      return StringRef(*this).indexOf(ch, fromIndex);
+    }
+
+    int indexOf(StringRef str, size_t fromIndex = 0) const {
+      return StringRef(*this).indexOf(str, fromIndex);
+    }
+
+    SmallString& operator+=(StringSpan str) {
+      append(str);
+      return *this;
+    }
+
+    SmallString& operator+=(const char* str) {
+      append(str);
+      return *this;
+    }
+
+    SmallString& operator+=(char c) {
+      append(c);
+      return *this;
+    }
+
+    bool operator==(StringRef other) const {
+      return StringRef::compare(*this, other) == 0;
+    }
+
+    bool operator!=(StringRef other) const {
+      return StringRef::compare(*this, other) != 0;
+    }
+
+    bool operator<(StringRef other) const {
+      return StringRef::compare(*this, other) < 0;
+    }
+
+    bool operator>(StringRef other) const {
+      return StringRef::compare(*this, other) > 0;
+    }
+
+  protected:
+    char* data_;
+    size_t length_;
+    size_t capacity_;
+    Alloc alloc_;
+    char inline_[N + 1];
+
+    bool growTo(size_t capacity) {
+      if (capacity + 1 < capacity) return false;
+      char* grown;
+      if (isInline()) {
+        grown = alloc_.allocate(capacity + 1);
+        if (grown != nullptr) memcpy(grown, inline_, length_ + 1);
+      }
+      else {
+        grown = alloc_.reallocate(data_, capacity_ + 1, capacity + 1);
+      }
+      if (grown == nullptr) return false;
+      data_ = grown;
+      capacity_ = capacity;
+      return true;
+    }
+
+    void release() {
+      if (!isInline()) alloc_.deallocate(data_, capacity_ + 1);
+      data_ = inline_;
+      capacity_ = N;
+      length_ = 0;
+      inline_[0] = '\0';
+    }
+
+    void take(SmallString& other) {
+      if (other.isInline()) {
+        memcpy(inline_, other.inline_, other.length_ + 1);
+        length_ = other.length_;
+      }
+      else {
+        data_ = other.data_;
+        length_ = other.length_;
+        capacity_ = other.capacity_;
+        other.data_ = other.inline_;
+        other.capacity_ = N;
+      }
+      other.length_ = 0;
+      other.inline_[0] = '\0';
+    }
+};
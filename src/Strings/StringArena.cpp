@@ -0,0 +1,74 @@
+#include "StringArena.h"
+
+#if RT_HAS_MAPPED_STRING_ARENA
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+char* StringArena::reallocate(char* block, size_t oldSize, size_t newSize) {
+  if (tryGrow(block, newSize)) return block;
+  char* moved = allocate(newSize);
+  if (moved == nullptr) return nullptr;
+  if (block != nullptr) memcpy(moved, block, oldSize < newSize ? oldSize : newSize);
+  return moved;
+}
+
+FixedString StringArena::grow(FixedString& str, size_t newCapacity) {
+  if (newCapacity >= UINT16_MAX) {
+    failures_++;
+    return FixedString();
+  }
+  char* data = (char*)str.c_str();
+  size_t length = data != nullptr ? strlen(data) : 0;
+  size_t oldSize = str.totalCapacity() + 1;
+  char* grown = reallocate(contains(data) ? data : nullptr, oldSize, newCapacity + 1);
+  if (grown == nullptr) return FixedString();
+  if (length > newCapacity) length = newCapacity;
+  if (grown != data && data != nullptr) memcpy(grown, data, length);
+  grown[length] = '\0';
+  FixedString result(grown, (uint16_t)(newCapacity + 1));
+  result.seekEnd();
+  return result;
+}
+
+size_t StringArena::printTo(Print& p) const {
+  size_t n = 0;
+  n += p.print("used=");
+  n += p.print((unsigned long)top_);
+  n += p.print(" high=");
+  n += p.print((unsigned long)highWater_);
+  n += p.print(" capacity=");
+  n += p.print((unsigned long)size_);
+  n += p.print(" allocations=");
+  n += p.print((unsigned long)allocations_);
+  n += p.print(" failed=");
+  n += p.print((unsigned long)failures_);
+  return n;
+}
+
+#if RT_HAS_MAPPED_STRING_ARENA
+
+static char* mapArena(size_t size) {
+  if (size == 0) return nullptr;
+  void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  return p == MAP_FAILED ? nullptr : (char*)p;
+}
+
+MappedStringArena::MappedStringArena(size_t size) :
+  StringArena(mapArena(size), size) {}
+
+MappedStringArena::~MappedStringArena() {
+  if (storage_ != nullptr) munmap(storage_, size_);
+}
+
+void MappedStringArena::trim() {
+  if (storage_ == nullptr) return;
+  size_t page = (size_t)sysconf(_SC_PAGESIZE);
+  size_t start = (top_ + page - 1) & ~(page - 1);
+  if (start >= size_) return;
+#if defined(MADV_DONTNEED)
+  madvise(storage_ + start, size_ - start, MADV_DONTNEED);
+#endif
+}
+
+#endif
@@ -0,0 +1,295 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+#include "./StringSpan.h"
+#include "./StringBuffer.h"
+#include "./FixedString.h"
+
+#if !defined(RT_HAS_ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define RT_HAS_MAPPED_STRING_ARENA 1
+#endif
+
+/**
+  * @brief Monotonic (bump) allocator for string buffers.
+  *
+  *  Buffers are carved off one block of memory in order and are never freed
+  *  one by one: reset() releases everything at once, e.g. at the end of a
+  *  frame or request, and a StringArenaScope releases everything allocated
+  *  since it was opened.  An allocation costs a bounds check and an add.
+  *
+  *  The most recent allocation can grow in place while nothing has been
+  *  allocated after it, which suits building a string of unknown length.
+  *
+  *  The arena keeps a high water mark and counts failed allocations, so
+  *  its size can be checked against real use; print it to see them.
+  *
+  *  The memory is supplied by the caller, see StaticStringArena and
+  *  MappedStringArena.  An arena is for one thread.
+  *
+  * @code
+  * StaticStringArena<4096> arena;
+  * void loop() {
+  *   StringArenaScope frame(arena);
+  *   FixedString line = arena.allocateString(80);
+  *   line.printf("gain=%d", gain);
+  *   ...
+  * }
+  * @endcode
+  */
+class StringArena : public Printable {
+  public:
+    /**
+      * @brief A position to rewind to, see mark()
+      */
+    struct Marker {
+      size_t top;
+    };
+
+    StringArena(char* storage, size_t size):
+      storage_(storage), size_(storage != nullptr ? size : 0), top_(0), last_(nullptr),
+      highWater_(0), allocations_(0), failures_(0){};
+
+    StringArena(const StringArena&) = delete;
+    StringArena& operator=(const StringArena&) = delete;
+
+    /**
+      * @brief Allocates size bytes, uninitialized
+      *
+      * @param align A power of two; strings need no alignment
+      * @return char* nullptr if the arena is full
+      */
+    char* allocate(size_t size, size_t align = 1) {
+      size_t start = (top_ + align - 1) & ~(align - 1);
+      if (start < top_ || start > size_ || size > size_ - start) {
+        failures_++;
+        return nullptr;
+      }
+      last_ = storage_ + start;
+      setTop(start + size);
+      allocations_++;
+      return last_;
+    }
+
+    /**
+      * @brief Allocates an empty, null terminated buffer for up to capacity
+      *        characters
+      *
+      * @return StringBuffer An empty StringBuffer (size 0) if the arena is full
+      */
+    StringBuffer allocateBuffer(size_t capacity) {
+      char* data = allocateZeroTerminated(capacity + 1);
+      return data != nullptr ? StringBuffer(data, (int)(capacity + 1)) : StringBuffer();
+    }
+
+    /**
+      * @brief Allocates a FixedString for up to capacity characters (at most
+      *        65534)
+      *
+      * @return FixedString A FixedString without storage if the arena is full
+      */
+    FixedString allocateString(size_t capacity) {
+      if (capacity >= UINT16_MAX) {
+        failures_++;
+        return FixedString();
+      }
+      char* data = allocateZeroTerminated(capacity + 1);
+      return data != nullptr ? FixedString(data, (uint16_t)(capacity + 1)) : FixedString();
+    }
+
+    /**
+      * @brief Copies str into the arena, null terminated
+      *
+      * @return const char* nullptr if the arena is full
+      */
+    const char* copy(StringSpan str) {
+      char* data = allocate(str.length() + 1);
+      if (data == nullptr) return nullptr;
+      memcpy(data, str.data(), str.length());
+      data[str.length()] = '\0';
+      return data;
+    }
+
+    /**
+      * @brief Resizes the most recent allocation in place
+      *
+      * @return false If block is not the most recent allocation or there is
+      *         no room; nothing changes
+      */
+    bool tryGrow(char* block, size_t newSize) {
+      if (block == nullptr || block != last_) return false;
+      size_t start = (size_t)(block - storage_);
+      if (newSize > size_ - start) return false;
+      setTop(start + newSize);
+      return true;
+    }
+
+    /**
+      * @brief Grows a block, in place if it is the most recent allocation and
+      *        otherwise by copying it to a new block; the old block stays
+      *        allocated until the arena or scope is released
+      *
+      * @return char* The block's new location, nullptr if the arena is full
+      */
+    char* reallocate(char* block, size_t oldSize, size_t newSize);
+
+    /**
+      * @brief Grows a FixedString allocated from this arena, keeping its
+      *        contents
+      *
+      * @return FixedString The string over its larger buffer, positioned at
+      *         its end, or a FixedString without storage if the arena is full
+      */
+    FixedString grow(FixedString& str, size_t newCapacity);
+
+    /**
+      * @brief Releases everything
+      */
+    void reset() {
+      top_ = 0;
+      last_ = nullptr;
+    }
+
+    Marker mark() const {
+      return Marker{ top_ };
+    }
+
+    /**
+      * @brief Releases everything allocated since the marker was taken
+      */
+    void rewind(Marker marker) {
+      if (marker.top > top_) return;
+      top_ = marker.top;
+      last_ = nullptr;
+    }
+
+    size_t capacity() const {
+      return size_;
+    }
+
+    size_t used() const {
+      return top_;
+    }
+
+    size_t remaining() const {
+      return size_ - top_;
+    }
+
+    /**
+      * @brief The most memory in use at any one time since construction or
+      *        resetStats()
+      */
+    size_t highWater() const {
+      return highWater_;
+    }
+
+    uint32_t allocationCount() const {
+      return allocations_;
+    }
+
+    /**
+      * @brief Allocations that did not fit; any at all means the arena is too
+      *        small
+      */
+    uint32_t failureCount() const {
+      return failures_;
+    }
+
+    void resetStats() {
+      highWater_ = top_;
+      allocations_ = 0;
+      failures_ = 0;
+    }
+
+    bool contains(const char* p) const {
+      return p >= storage_ && p < storage_ + size_;
+    }
+
+    /**
+      * @brief Prints used, high water mark, capacity, allocations and
+      *        failures on one line
+      */
+    size_t printTo(Print& p) const override;
+
+  protected:
+    char* storage_;
+    size_t size_;
+    size_t top_;
+    char* last_;
+    size_t highWater_;
+    uint32_t allocations_;
+    uint32_t failures_;
+
+    void setTop(size_t top) {
+      top_ = top;
+      if (top > highWater_) highWater_ = top;
+    }
+
+    char* allocateZeroTerminated(size_t size) {
+      char* data = allocate(size);
+      if (data != nullptr) data[0] = '\0';
+      return data;
+    }
+};
+
+/**
+  * @brief Releases everything allocated from an arena during its lifetime;
+  *        scopes can be nested
+  */
+class StringArenaScope {
+  public:
+    StringArenaScope(StringArena& arena): arena_(arena), marker_(arena.mark()){};
+
+    ~StringArenaScope() {
+      arena_.rewind(marker_);
+    }
+
+    StringArenaScope(const StringArenaScope&) = delete;
+    StringArenaScope& operator=(const StringArenaScope&) = delete;
+
+  protected:
+    StringArena& arena_;
+    StringArena::Marker marker_;
+};
+
+/**
+  * @brief A StringArena that owns its memory
+  *
+  * @tparam SIZE The arena size in bytes
+  */
+template<size_t SIZE>
+class StaticStringArena : public StringArena {
+  static_assert(SIZE > 0, "SIZE must be greater than zero");
+  public:
+    StaticStringArena(): StringArena(sstorage_, SIZE){};
+  protected:
+    char sstorage_[SIZE];
+};
+
+#if RT_HAS_MAPPED_STRING_ARENA
+/**
+  * @brief A StringArena over an anonymous memory mapping.
+  *
+  *  The OS only commits the pages the arena actually touches, so a large
+  *  arena costs what its high water mark costs.  trim() hands the pages
+  *  above the current use back to the OS.
+  */
+class MappedStringArena : public StringArena {
+  public:
+    MappedStringArena(size_t size);
+    ~MappedStringArena();
+
+    /**
+      * @brief False if the mapping failed; the arena then has no capacity
+      */
+    bool isValid() const {
+      return storage_ != nullptr;
+    }
+
+    /**
+      * @brief Returns the whole pages above the current use to the OS; their
+      *        contents are lost
+      */
+    void trim();
+};
+#endif
@@ -0,0 +1,213 @@
+#include "StringRope.h"
+#include <stdarg.h>
+#include <stdio.h>
+
+#if RT_HAS_WRITEV
+#include <errno.h>
+#include <unistd.h>
+#endif
+
+StringChunkPool::StringChunkPool(char* storage, size_t size, size_t chunkSize) :
+  storage_(storage), chunkSize_(chunkSize), count_(0), carved_(0), available_(0), free_(nullptr) {
+  if (storage != nullptr && chunkSize >= sizeof(FreeChunk) && chunkSize % sizeof(void*) == 0) {
+    count_ = size / chunkSize;
+    available_ = count_;
+  }
+}
+
+char* StringChunkPool::acquire() {
+  if (free_ != nullptr) {
+    FreeChunk* chunk = free_;
+    free_ = chunk->next;
+    available_--;
+    return (char*)chunk;
+  }
+  if (carved_ == count_) return nullptr;
+  available_--;
+  return storage_ + chunkSize_ * carved_++;
+}
+
+void StringChunkPool::release(char* chunk) {
+  if (chunk == nullptr) return;
+  FreeChunk* freed = (FreeChunk*)chunk;
+  freed->next = free_;
+  free_ = freed;
+  available_++;
+}
+
+StringRope::StringRope(StringChunkPool& pool) :
+  pool_(&pool), arena_(nullptr),
+  chunkCapacity_(pool.chunkSize() > sizeof(Chunk) + 1 ? pool.chunkSize() - sizeof(Chunk) - 1 : 0),
+  head_(nullptr), tail_(nullptr), length_(0), segments_(0) {}
+
+StringRope::StringRope(StringArena& arena, size_t chunkSize) :
+  pool_(nullptr), arena_(&arena),
+  chunkCapacity_(chunkSize > sizeof(Chunk) + 1 ? chunkSize - sizeof(Chunk) - 1 : 0),
+  head_(nullptr), tail_(nullptr), length_(0), segments_(0) {}
+
+StringRope::~StringRope() {
+  reset();
+}
+
+bool StringRope::addChunk() {
+  if (chunkCapacity_ == 0) return false;
+  char* memory = pool_ != nullptr ? pool_->acquire()
+    : arena_->allocate(sizeof(Chunk) + chunkCapacity_ + 1, alignof(Chunk));
+  if (memory == nullptr) return false;
+  Chunk* chunk = (Chunk*)memory;
+  chunk->next = nullptr;
+  chunk->length = 0;
+  if (tail_ != nullptr) tail_->next = chunk;
+  else head_ = chunk;
+  tail_ = chunk;
+  segments_++;
+  return true;
+}
+
+size_t StringRope::write(uint8_t c) {
+  if (room() == 0 && !addChunk()) {
+    setWriteError();
+    return 0;
+  }
+  *end() = (char)c;
+  tail_->length++;
+  length_++;
+  return 1;
+}
+
+size_t StringRope::write(const uint8_t* buffer, size_t size) {
+  size_t written = 0;
+  while (written < size) {
+    if (room() == 0 && !addChunk()) {
+      setWriteError();
+      break;
+    }
+    size_t toCopy = room();
+    if (toCopy > size - written) toCopy = size - written;
+    memcpy(end(), buffer + written, toCopy);
+    tail_->length += toCopy;
+    written += toCopy;
+  }
+  length_ += written;
+  return written;
+}
+
+size_t StringRope::printf(const char* format, ...) {
+  if (room() == 0 && !addChunk()) {
+    setWriteError();
+    return 0;
+  }
+  va_list args;
+  va_start(args, format);
+  va_list retry;
+  va_copy(retry, args);
+  int n = vsnprintf(end(), room() + 1, format, args);
+  va_end(args);
+  size_t size = n > 0 ? (size_t)n : 0;
+  if (size > room()) {
+    // Keep the text of one call in one chunk: start a fresh one unless this
+    // one is fresh already, else keep what fitted
+    if (tail_->length > 0 && addChunk()) vsnprintf(end(), room() + 1, format, retry);
+    if (size > room()) {
+      setWriteError();
+      size = room();
+    }
+  }
+  va_end(retry);
+  tail_->length += size;
+  length_ += size;
+  return size;
+}
+
+void StringRope::reset() {
+  if (pool_ != nullptr) {
+    Chunk* chunk = head_;
+    while (chunk != nullptr) {
+      Chunk* next = chunk->next;
+      pool_->release((char*)chunk);
+      chunk = next;
+    }
+  }
+  head_ = nullptr;
+  tail_ = nullptr;
+  length_ = 0;
+  segments_ = 0;
+}
+
+StringSpan StringRope::segment(size_t index) const {
+  const Chunk* chunk = head_;
+  while (chunk != nullptr && index-- > 0) chunk = chunk->next;
+  return chunk != nullptr ? StringSpan(chunk->data(), chunk->length) : StringSpan();
+}
+
+size_t StringRope::printTo(Print& p) const {
+  size_t n = 0;
+  forEachSegment([&](StringSpan s) { n += p.write(s.data(), s.length()); });
+  return n;
+}
+
+size_t StringRope::flatten(char* buffer, size_t size) const {
+  if (buffer == nullptr || size == 0) return 0;
+  size_t copied = 0;
+  for (const Chunk* chunk = head_; chunk != nullptr && copied < size - 1; chunk = chunk->next) {
+    size_t toCopy = chunk->length;
+    if (toCopy > size - 1 - copied) toCopy = size - 1 - copied;
+    memcpy(buffer + copied, chunk->data(), toCopy);
+    copied += toCopy;
+  }
+  buffer[copied] = '\0';
+  return copied;
+}
+
+StringSpan StringRope::flatten(StringArena& arena) const {
+  char* buffer = arena.allocate(length_ + 1);
+  if (buffer == nullptr) return StringSpan();
+  return StringSpan(buffer, flatten(buffer, length_ + 1));
+}
+
+#if RT_HAS_WRITEV
+
+size_t StringRope::fillIovec(const Chunk* chunk, size_t offset, struct iovec* iov, size_t count) {
+  size_t filled = 0;
+  for (; chunk != nullptr && filled < count; chunk = chunk->next) {
+    if (offset >= chunk->length) {
+      offset -= chunk->length;
+      continue;
+    }
+    iov[filled].iov_base = (void*)(chunk->data() + offset);
+    iov[filled].iov_len = chunk->length - offset;
+    offset = 0;
+    filled++;
+  }
+  return filled;
+}
+
+size_t StringRope::toIovec(struct iovec* iov, size_t count, size_t offset) const {
+  return fillIovec(head_, offset, iov, count);
+}
+
+long StringRope::writeTo(int fd) const {
+  static constexpr size_t kBatch = 16;
+  struct iovec iov[kBatch];
+  const Chunk* chunk = head_;
+  size_t offset = 0;
+  long total = 0;
+  size_t filled;
+  while ((filled = fillIovec(chunk, offset, iov, kBatch)) > 0) {
+    ssize_t n = writev(fd, iov, (int)filled);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return total > 0 ? total : -1;
+    }
+    total += n;
+    // Step past what was written, which may end inside a chunk
+    offset += (size_t)n;
+    while (chunk != nullptr && offset >= chunk->length) {
+      offset -= chunk->length;
+      chunk = chunk->next;
+    }
+  }
+  return total;
+}
+
+#endif
@@ -0,0 +1,257 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+#include "./StringSpan.h"
+#include "./StringArena.h"
+
+#if !defined(RT_HAS_ARDUINO) && (defined(__unix__) || defined(__APPLE__))
+#define RT_HAS_WRITEV 1
+#include <sys/uio.h>
+#endif
+
+/**
+  * @brief A pool of equally sized chunks for StringRope.
+  *
+  *  Chunks are carved from caller supplied memory as they are first needed
+  *  and go onto a free list when a rope releases them, so acquiring and
+  *  releasing a chunk is a few pointer moves.  A pool is for one thread.
+  */
+class StringChunkPool {
+  public:
+    StringChunkPool(char* storage, size_t size, size_t chunkSize);
+
+    StringChunkPool(const StringChunkPool&) = delete;
+    StringChunkPool& operator=(const StringChunkPool&) = delete;
+
+    /**
+      * @brief A chunk of chunkSize() bytes, aligned for a pointer
+      *
+      * @return char* nullptr if every chunk is in use
+      */
+    char* acquire();
+
+    void release(char* chunk);
+
+    size_t chunkSize() const {
+      return chunkSize_;
+    }
+
+    /**
+      * @brief The number of chunks the memory holds
+      */
+    size_t chunkCount() const {
+      return count_;
+    }
+
+    /**
+      * @brief Chunks not in use
+      */
+    size_t available() const {
+      return available_;
+    }
+
+  protected:
+    struct FreeChunk {
+      FreeChunk* next;
+    };
+
+    char* storage_;
+    size_t chunkSize_;
+    size_t count_;
+    size_t carved_;
+    size_t available_;
+    FreeChunk* free_;
+};
+
+/**
+  * @brief A StringChunkPool that owns its memory
+  *
+  * @tparam CHUNK_SIZE Bytes per chunk, including a small header
+  * @tparam COUNT The number of chunks
+  */
+template<size_t CHUNK_SIZE, size_t COUNT>
+class StaticStringChunkPool : public StringChunkPool {
+  static_assert(CHUNK_SIZE % sizeof(void*) == 0, "CHUNK_SIZE must be a multiple of the pointer size");
+  static_assert(COUNT > 0, "COUNT must be greater than zero");
+  public:
+    StaticStringChunkPool(): StringChunkPool((char*)sstorage_, sizeof(sstorage_), CHUNK_SIZE){};
+  protected:
+    void* sstorage_[CHUNK_SIZE * COUNT / sizeof(void*)];
+};
+
+/**
+  * @brief A string builder that chains fixed size chunks instead of
+  *        growing one contiguous buffer.
+  *
+  *  Writing never moves what was written before: when the current chunk is
+  *  full the rope takes another one from its StringChunkPool or StringArena
+  *  and carries on there.  That suits large output such as status pages and
+  *  JSON dumps, which would otherwise need a buffer sized for the worst
+  *  case or a copy each time the buffer grows.
+  *
+  *  The text is read as a list of segments, one per chunk, each a
+  *  StringSpan into the chunk (segments are not null terminated).  On POSIX
+  *  the segments go to a file descriptor in one writev() call per 16
+  *  segments, see writeTo().  flatten() copies the text into one buffer and
+  *  only runs when asked to.
+  *
+  *  When no chunk is available writes are truncated and the write error is
+  *  set.  Chunks from a pool go back to it on reset() and destruction;
+  *  chunks from an arena are released with the arena or its scope.
+  *
+  * @code
+  * static StaticStringChunkPool<512, 32> pool;
+  * StringRope page(pool);
+  * JsonWriter json(page);
+  * ...
+  * page.writeTo(clientFd);
+  * @endcode
+  */
+class StringRope : public Print, public Printable {
+  public:
+    StringRope(StringChunkPool& pool);
+
+    /**
+      * @param chunkSize Bytes taken from the arena per chunk, including a
+      *        small header
+      */
+    StringRope(StringArena& arena, size_t chunkSize = 256);
+
+    ~StringRope();
+
+    StringRope(const StringRope&) = delete;
+    StringRope& operator=(const StringRope&) = delete;
+
+    using Print::write;
+
+    size_t write(uint8_t c) override;
+    size_t write(const uint8_t* buffer, size_t size) override;
+
+    size_t append(StringSpan str) {
+      return write((const uint8_t*)str.data(), str.length());
+    }
+
+    size_t append(char c) {
+      return write((uint8_t)c);
+    }
+
+    /**
+      * @brief Appends printf formatted text.  The text of one call is kept
+      *        in one chunk, so it is truncated at the chunk capacity
+      */
+    size_t printf(const char* format, ...);
+
+    /**
+      * @brief Empties the rope and returns pool chunks to the pool
+      */
+    void reset();
+
+    /**
+      * @brief Total characters in all segments
+      */
+    size_t length() const {
+      return length_;
+    }
+
+    bool isEmpty() const {
+      return length_ == 0;
+    }
+
+    size_t segmentCount() const {
+      return segments_;
+    }
+
+    /**
+      * @brief The index'th segment; walks the chain, prefer forEachSegment()
+      */
+    StringSpan segment(size_t index) const;
+
+    /**
+      * @brief Calls f(StringSpan) for each non empty segment in order
+      */
+    template<typename F>
+    void forEachSegment(F f) const {
+      for (const Chunk* chunk = head_; chunk != nullptr; chunk = chunk->next) {
+        if (chunk->length > 0) f(StringSpan(chunk->data(), chunk->length));
+      }
+    }
+
+    /**
+      * @brief Writes the segments to p without flattening them
+      */
+    size_t printTo(Print& p) const override;
+
+    /**
+      * @brief Copies the text into buffer, null terminated
+      *
+      * @return size_t Characters copied, less than length() if buffer is
+      *         too small
+      */
+    size_t flatten(char* buffer, size_t size) const;
+
+    /**
+      * @brief Copies the text into one null terminated arena allocation
+      *
+      * @return StringSpan An empty span if the arena is full
+      */
+    StringSpan flatten(StringArena& arena) const;
+
+#if RT_HAS_WRITEV
+    /**
+      * @brief Fills iov with the segments, skipping the first offset
+      *        characters
+      *
+      * @return size_t The number of iovecs filled, at most count
+      */
+    size_t toIovec(struct iovec* iov, size_t count, size_t offset = 0) const;
+
+    /**
+      * @brief Writes the whole text to fd with writev(), resuming after short
+      *        writes and EINTR
+      *
+      * @return long Characters written, or -1 if writev() failed before
+      *         anything was written
+      */
+    long writeTo(int fd) const;
+#endif
+
+  protected:
+    struct Chunk {
+      Chunk* next;
+      size_t length;
+
+      char* data() {
+        return (char*)(this + 1);
+      }
+
+      const char* data() const {
+        return (const char*)(this + 1);
+      }
+    };
+
+    StringChunkPool* pool_;
+    StringArena* arena_;
+
+    // Each chunk keeps one byte past its capacity for the terminator that
+    // vsnprintf() writes
+    size_t chunkCapacity_;
+    Chunk* head_;
+    Chunk* tail_;
+    size_t length_;
+    size_t segments_;
+
+    char* end() {
+      return tail_->data() + tail_->length;
+    }
+
+    size_t room() const {
+      return tail_ != nullptr ? chunkCapacity_ - tail_->length : 0;
+    }
+
+    bool addChunk();
+
+#if RT_HAS_WRITEV
+    static size_t fillIovec(const Chunk* chunk, size_t offset, struct iovec* iov, size_t count);
+#endif
+};
@@ -0,0 +1,86 @@
+#pragma once
+
+#include "./StringDeps.h"
+#include "./StringRef.h"
+
+/**
+  * @brief A non owning, sized view of characters.
+  *
+  *  Unlike StringRef the characters need not be null terminated, so a
+  *  StringSpan can refer to a piece of a larger buffer (a parsed token, one
+  *  segment of a ring buffer) without copying it.
+  */
+class StringSpan {
+  public:
+    constexpr StringSpan(): data_(""), length_(0){};
+
+    constexpr StringSpan(const char* data, size_t length):
+      data_(data != nullptr ? data : ""), length_(data != nullptr ? length : 0){};
+
+    StringSpan(const char* str): data_(str != nullptr ? str : ""), length_(str != nullptr ? strlen(str) : 0){};
+
+    StringSpan(StringRef str): data_(str), length_(str.length()){};
+
+    const char* data() const {
+      return data_;
+    }
+
+    size_t length() const {
+      return length_;
+    }
+
+    bool isEmpty() const {
+      return length_ == 0;
+    }
+
+    char charAt(size_t loc) const {
+      if (loc >= length_) return '\0';
+      else return data_[loc];
+    }
+
+    char operator[](size_t index) const {
+      return charAt(index);
+    }
+
+    StringSpan subSpan(size_t start, size_t length) const {
+      if (start > length_) start = length_;
+      if (length > length_ - start) length = length_ - start;
+      return StringSpan(data_ + start, length);
+    }
+
+    StringSpan subSpan(size_t start) const {
+      return subSpan(start, length_);
+    }
+
+    int indexOf(char ch, size_t fromIndex = 0) const {
+      if (fromIndex >= length_) return -1;
+      const void* found = memchr(data_ + fromIndex, ch, length_ - fromIndex);
+      return found ? (int)((const char*)found - data_) : -1;
+    }
+
+    bool startsWith(StringSpan prefix) const {
+      return prefix.length_ <= length_ && memcmp(data_, prefix.data_, prefix.length_) == 0;
+    }
+
+    bool equals(StringSpan other) const {
+      return length_ == other.length_ && memcmp(data_, other.data_, length_) == 0;
+    }
+
+    /**
+      * @brief Writes the characters to p
+      */
+    size_t printTo(Print& p) const {
+      return p.write(data_, length_);
+    }
+
+    friend bool operator==(StringSpan lhs, StringSpan rhs) {
+      return lhs.equals(rhs);
+    }
+
+    friend bool operator!=(StringSpan lhs, StringSpan rhs) {
+      return !lhs.equals(rhs);
+    }
+  protected:
+    const char* data_;
+    size_t length_;
+};
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "./TimeDeps.h"
+
+/*
+  Clock policies.  Each exposes the tick type (rep), the number of ticks per
+  second and a static now().  Timers and schedulers take a policy as a
+  template parameter, so the clock is chosen at compile time and now() is
+  inlined.  Elapsed times are computed by unsigned subtraction in rep, which
+  stays correct across a wrap of the counter.
+*/
+
+/**
+  * @brief 32 bit milliseconds from millis(), wraps after ~49 days
+  */
+struct MillisClock {
+  typedef uint32_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000ull;
+  static rep now() { return millis(); }
+};
+
+/**
+  * @brief 32 bit microseconds from micros(), wraps after ~71 minutes
+  */
+struct MicrosClock {
+  typedef uint32_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000000ull;
+  static rep now() { return micros(); }
+};
+
+/**
+  * @brief 64 bit milliseconds from millis64()
+  */
+struct Millis64Clock {
+  typedef uint64_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000ull;
+  static rep now() { return millis64(); }
+};
+
+/**
+  * @brief 64 bit microseconds from micros64()
+  */
+struct Micros64Clock {
+  typedef uint64_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000000ull;
+  static rep now() { return micros64(); }
+};
+
+/**
+  * @brief 64 bit nanoseconds from nanos()
+  */
+struct NanosClock {
+  typedef uint64_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000000000ull;
+  static rep now() { return nanos(); }
+};
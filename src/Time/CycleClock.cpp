@@ -0,0 +1,87 @@
+#include "CycleClock.h"
+
+#if RT_CYCLE_CLOCK_X86 && !defined(_MSC_VER)
+#include <cpuid.h>
+#endif
+
+uint64_t CycleClock::frequency_ = 0;
+uint64_t CycleClock::mult_ = 0;
+uint8_t CycleClock::shift_ = 0;
+
+void CycleClock::setFrequency(uint64_t hz) {
+  if (hz == 0) return;
+  uint8_t shift = 32;
+  uint64_t mult = (1000000000ull << 32) / hz;
+  while (mult >= (1ull << 32) && shift > 0) {
+    shift--;
+    mult = (1000000000ull << shift) / hz;
+  }
+  mult_ = mult;
+  shift_ = shift;
+  frequency_ = hz;
+}
+
+void CycleClock::begin() {
+#if RT_CYCLE_CLOCK_DWT
+  volatile uint32_t* demcr = (volatile uint32_t*)0xE000EDFC;
+  volatile uint32_t* lar = (volatile uint32_t*)0xE0001FB0;
+  volatile uint32_t* ctrl = (volatile uint32_t*)0xE0001000;
+  *demcr |= (1u << 24); // TRCENA
+  *lar = 0xC5ACCE55;    // Unlock, needed on Cortex-M7
+  *ctrl |= 1u;          // CYCCNTENA
+#elif RT_CYCLE_CLOCK_ARM64
+  uint64_t hz;
+  asm volatile("mrs %0, cntfrq_el0" : "=r"(hz));
+  setFrequency(hz);
+#endif
+}
+
+void CycleClock::calibrate(uint32_t durationUs) {
+#if RT_CYCLE_CLOCK_ARM64
+  begin();
+#elif RT_CYCLE_CLOCK_X86 || RT_CYCLE_CLOCK_DWT
+  // Against the real timebase: simulated time stands still while spinning
+  uint64_t duration = (uint64_t)durationUs * 1000ull;
+  uint64_t t0 = realNanos();
+  rep c0 = now();
+  uint64_t t1;
+  do {
+    t1 = realNanos();
+  } while (t1 - t0 < duration);
+  rep c1 = nowOrdered();
+  uint64_t elapsed = t1 - t0;
+  uint64_t cycles = (rep)(c1 - c0);
+  setFrequency((cycles / elapsed) * 1000000000ull + ((cycles % elapsed) * 1000000000ull) / elapsed);
+#else
+  (void)durationUs;
+  setFrequency(1000000000ull);
+#endif
+}
+
+bool CycleClock::isInvariant() {
+#if RT_CYCLE_CLOCK_X86
+  unsigned int regs[4] = { 0, 0, 0, 0 };
+#if defined(_MSC_VER)
+  __cpuid((int*)regs, 0x80000000);
+  if (regs[0] < 0x80000007) return false;
+  __cpuid((int*)regs, 0x80000007);
+#else
+  if (__get_cpuid_max(0x80000000, nullptr) < 0x80000007) return false;
+  __cpuid(0x80000007, regs[0], regs[1], regs[2], regs[3]);
+#endif
+  return (regs[3] & (1u << 8)) != 0;
+#else
+  // The AArch64 generic timer and the Cortex-M core clock do not vary with
+  // power states; the nanos() fallback is monotonic by definition.
+  return true;
+#endif
+}
+
+#if RT_CYCLE_CLOCK_LAZY
+bool CycleClock::calibrateIfNeeded() {
+  // Short, as it runs inside whichever call needed the frequency first; an
+  // earlier calibrate() call is kept
+  if (!isCalibrated()) calibrate(2000);
+  return true;
+}
+#endif
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "./TimeDeps.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define RT_CYCLE_CLOCK_X86 1
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#elif defined(__aarch64__)
+#define RT_CYCLE_CLOCK_ARM64 1
+#elif defined(__ARM_ARCH_7M__) || defined(__ARM_ARCH_7EM__) || defined(__ARM_ARCH_8M_MAIN__)
+#define RT_CYCLE_CLOCK_DWT 1
+#endif
+
+#if !RT_CYCLE_CLOCK_DWT && !defined(RT_HAS_ARDUINO)
+#define RT_CYCLE_CLOCK_LAZY 1 //!< Calibrated on first use rather than by the caller
+#endif
+
+/**
+  * @brief Reads the CPU's cycle counter: the TSC on x86, the generic timer
+  *        (cntvct_el0) on AArch64 and the DWT cycle counter on Cortex-M3 and up.
+  *        Other targets fall back to nanos().
+  *
+  *  Reading the counter costs a few nanoseconds, several times less than
+  *  clock_gettime().  Converting to nanoseconds needs the counter frequency,
+  *  which is measured by calibrate() against realNanos(), so a SimulatedClock
+  *  does not affect it.  On hosted builds the first frequency() or toNanos()
+  *  call calibrates if nothing has yet, with a 2 ms spin on x86 (on AArch64
+  *  the frequency is read from cntfrq_el0); call calibrate() up front to keep
+  *  that spin out of a timed path or for a closer estimate.  On Cortex-M call
+  *  begin() and then calibrate() once the system timer is running.
+  */
+class CycleClock
+{
+public:
+#if RT_CYCLE_CLOCK_DWT
+  typedef uint32_t rep; //!< CYCCNT is 32 bits wide; elapsed times are taken modulo 2^32
+#else
+  typedef uint64_t rep;
+#endif
+  static constexpr uint64_t kTicksPerSecond = 0; //!< Known only at runtime, see frequency()
+
+  /**
+    * @brief Reads the counter. The read may be reordered with neighbouring
+    *        instructions; use nowOrdered() at the end of a measured region.
+    */
+  static rep now() {
+#if RT_CYCLE_CLOCK_X86
+    return __rdtsc();
+#elif RT_CYCLE_CLOCK_ARM64
+    uint64_t v;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(v));
+    return v;
+#elif RT_CYCLE_CLOCK_DWT
+    return *(volatile uint32_t*)0xE0001004;
+#else
+    return nanos();
+#endif
+  }
+
+  /**
+    * @brief Reads the counter after all preceding instructions have completed
+    *        (rdtscp on x86, isb on AArch64).
+    */
+  static rep nowOrdered() {
+#if RT_CYCLE_CLOCK_X86
+    unsigned int aux;
+    return __rdtscp(&aux);
+#elif RT_CYCLE_CLOCK_ARM64
+    uint64_t v;
+    asm volatile("isb; mrs %0, cntvct_el0" : "=r"(v) : : "memory");
+    return v;
+#else
+    return now();
+#endif
+  }
+
+  /**
+    * @brief Enables the counter where that is needed (DWT on Cortex-M)
+    */
+  static void begin();
+
+  /**
+    * @brief Measures the counter frequency against realNanos() by spinning
+    *        for the given time
+    */
+  static void calibrate(uint32_t durationUs = 10000);
+
+  static bool isCalibrated() { return frequency_ != 0; }
+
+  /**
+    * @brief True if the counter runs at a constant rate regardless of power
+    *        states and frequency scaling (invariant TSC on x86)
+    */
+  static bool isInvariant();
+
+  /**
+    * @brief Counter frequency in Hz, 0 before calibration
+    */
+  static uint64_t frequency() {
+    calibrateOnFirstUse();
+    return frequency_;
+  }
+
+  /**
+    * @brief Converts a number of counter ticks to nanoseconds using fixed
+    *        point arithmetic
+    */
+  static uint64_t toNanos(uint64_t cycles) {
+    calibrateOnFirstUse();
+#if defined(__SIZEOF_INT128__)
+    return (uint64_t)(((unsigned __int128)cycles * mult_) >> shift_);
+#else
+    uint64_t hi = cycles >> 32;
+    uint64_t lo = cycles & 0xffffffffull;
+    return ((hi * mult_) << (32 - shift_)) + ((lo * mult_) >> shift_);
+#endif
+  }
+
+protected:
+  static uint64_t frequency_;
+  static uint64_t mult_;  //!< Nanoseconds per tick scaled by 2^shift_, kept below 2^32
+  static uint8_t shift_;
+
+  static void setFrequency(uint64_t hz);
+
+#if RT_CYCLE_CLOCK_LAZY
+  static bool calibrateIfNeeded();
+
+  static void calibrateOnFirstUse() {
+    // A function local static is initialized once, thread safely, and costs
+    // a predicted branch afterwards
+    static const bool calibrated = calibrateIfNeeded();
+    (void)calibrated;
+  }
+#else
+  static void calibrateOnFirstUse() {}
+#endif
+};
+
+/**
+  * @brief Clock policy returning nanoseconds derived from the cycle counter.
+  *        Cheaper than NanosClock where the counter is, at the price of
+  *        calibration error.
+  */
+struct CycleNanosClock {
+  typedef uint64_t rep;
+  static constexpr uint64_t kTicksPerSecond = 1000000000ull;
+  static rep now() { return CycleClock::toNanos(CycleClock::now()); }
+};
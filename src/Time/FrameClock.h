@@ -0,0 +1,74 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./Clocks.h"
+
+/**
+  * @brief A clock policy that returns the time sampled at the start of the
+  *        current loop pass.
+  *
+  *  Call tick() once at the top of every loop pass; until the next tick()
+  *  every timer built on the FrameClock sees the same time.  That is one
+  *  clock read per pass however many timers are checked, and timers that
+  *  share a timeout expire on the same pass.
+  *
+  *  Frame time is in the source clock's ticks, so it mixes freely with
+  *  times taken from the source directly.  The few timers that must see the
+  *  exact time use the source clock (the Fresh typedef), and code inside a
+  *  pass can read it with fresh().
+  *
+  *  The frame time is shared by all users of the same FrameClock type.  A
+  *  second loop, e.g. on another thread, gives its FrameClock a different
+  *  Tag type so the two do not overwrite each other.
+  *
+  * @code
+  * FrameTimer blink(500);     // ClockTimer<FrameClock<MillisClock>>
+  * FrameTimer report(1000);
+  * void loop() {
+  *   FrameClock<>::tick();
+  *   blink.onExpire(toggleLed);
+  *   report.onExpire(sendReport);
+  * }
+  * @endcode
+  *
+  * @tparam Source The clock policy sampled by tick() (see Time/Clocks.h)
+  * @tparam Tag Any type, to keep the frame times of separate loops apart
+  */
+template<typename Source = MillisClock, typename Tag = void>
+struct FrameClock {
+  typedef typename Source::rep rep;
+  typedef Source Fresh; //!< The uncached clock, for timers that need the exact time
+  static constexpr uint64_t kTicksPerSecond = Source::kTicksPerSecond;
+
+  /**
+    * @brief The time of the last tick()
+    */
+  static rep now() { return frame_; }
+
+  /**
+    * @brief Samples the source clock and starts a new frame
+    *
+    * @return rep The new frame time
+    */
+  static rep tick() {
+    frame_ = Source::now();
+    return frame_;
+  }
+
+  /**
+    * @brief Reads the source clock without changing the frame time
+    */
+  static rep fresh() { return Source::now(); }
+
+  /**
+    * @brief Source ticks since the last tick(), e.g. to see how far a long
+    *        pass has drifted from its frame time
+    */
+  static rep age() { return (rep)(Source::now() - frame_); }
+
+protected:
+  static rep frame_;
+};
+
+template<typename Source, typename Tag>
+typename Source::rep FrameClock<Source, Tag>::frame_ = 0;
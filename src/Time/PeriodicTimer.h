@@ -0,0 +1,270 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./Clocks.h"
+#include <math.h>
+
+/**
+  * @brief How a PeriodicTimer schedules its next deadline
+  */
+enum class PeriodicMode {
+  FixedRate,  //!< Deadlines lie on a fixed grid, deadline += period, so late polls do not drift
+  FixedDelay  //!< The next deadline is one period after the callback ran
+};
+
+/**
+  * @brief What a fixed rate PeriodicTimer does when polled more than a
+  *        period late
+  */
+enum class CatchUp {
+  Skip,     //!< Fire once and drop the missed deadlines
+  Burst,    //!< Fire once for every missed deadline, back to back
+  Coalesce  //!< Fire once, reporting how many deadlines the call stands for
+};
+
+/**
+  * @brief Running statistics of how late a periodic timer fired, in clock
+  *        ticks
+  */
+class JitterStats
+{
+public:
+  JitterStats() { reset(); }
+
+  void reset() {
+    count_ = 0;
+    min_ = 0;
+    max_ = 0;
+    sum_ = 0;
+    sumSquares_ = 0;
+  }
+
+  void add(uint64_t lateness) {
+    if (count_ == 0 || lateness < min_) min_ = lateness;
+    if (lateness > max_) max_ = lateness;
+    count_++;
+    sum_ += lateness;
+    sumSquares_ += (double)lateness * (double)lateness;
+  }
+
+  uint32_t count() const { return count_; }
+  uint64_t min() const { return min_; }
+  uint64_t max() const { return max_; }
+
+  double mean() const {
+    return count_ ? (double)sum_ / count_ : 0.0;
+  }
+
+  /**
+    * @brief Standard deviation of the lateness
+    */
+  double stddev() const {
+    if (count_ < 2) return 0.0;
+    double m = mean();
+    double variance = sumSquares_ / count_ - m * m;
+    return variance > 0.0 ? sqrt(variance) : 0.0;
+  }
+
+protected:
+  uint32_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  uint64_t sum_;
+  double sumSquares_;
+};
+
+/**
+  * @brief A periodic timer that keeps to its period.
+  *
+  *  ClockTimer::onExpire() restarts the timeout from the time of the poll, so
+  *  each period stretches by however late the poll was.  In FixedRate mode a
+  *  PeriodicTimer instead moves its deadline forward by exactly one period,
+  *  so a 1 kHz loop fires 1000 times a second on average however jittery the
+  *  polling is.  When a poll is more than a period late the CatchUp policy
+  *  decides what happens to the deadlines that were missed.
+  *
+  *  Lateness of every firing is collected in jitter(); deadlines dropped or
+  *  folded together are counted by missedTicks(), and callbacks that ran for
+  *  longer than a period by overruns().
+  *
+  * @code
+  * PeriodicTimer<MicrosClock> sampler(1000);
+  * sampler.begin();
+  * ...
+  * sampler.onExpire([] { takeSample(); });
+  * @endcode
+  *
+  * @tparam Clock The clock policy (see Time/Clocks.h); periods are in its ticks
+  */
+template<typename Clock = MillisClock>
+class PeriodicTimer
+{
+public:
+  typedef typename Clock::rep rep;
+
+  static constexpr rep kMaxLateness = (rep)~(rep)0 / 2; //!< Later than this reads as "not yet due"
+
+  PeriodicTimer(rep period = 1000, PeriodicMode mode = PeriodicMode::FixedRate,
+    CatchUp catchUp = CatchUp::Skip) :
+    deadline_(0), period_(period ? period : 1), mode_(mode), catchUp_(catchUp), lastTicks_(0) {
+    resetStats();
+  };
+
+  /**
+    * @brief Starts the timer; the first deadline is one period from now.
+    *        Statistics are cleared.
+    */
+  void begin() {
+    deadline_ = now() + period_;
+    lastTicks_ = 0;
+    resetStats();
+  }
+
+  void begin(rep period) {
+    setPeriod(period);
+    begin();
+  }
+
+  /**
+    * @brief Changes the period; the current deadline is kept
+    */
+  void setPeriod(rep period) { period_ = period ? period : 1; }
+  rep period() const { return period_; }
+
+  void setMode(PeriodicMode mode) { mode_ = mode; }
+  PeriodicMode mode() const { return mode_; }
+
+  void setCatchUp(CatchUp catchUp) { catchUp_ = catchUp; }
+  CatchUp catchUp() const { return catchUp_; }
+
+  static rep now() { return Clock::now(); }
+
+  /**
+    * @brief The time at which the timer is next due
+    */
+  rep deadline() const { return deadline_; }
+
+  bool hasExpired() const {
+    return (rep)(now() - deadline_) <= kMaxLateness;
+  }
+
+  /**
+    * @brief The number of deadlines that have passed without firing
+    */
+  rep pendingTicks() const {
+    rep late = now() - deadline_;
+    if (late > kMaxLateness) return 0;
+    return mode_ == PeriodicMode::FixedDelay ? 1 : late / period_ + 1;
+  }
+
+  /**
+    * @brief Checks the timer and, if it is due, moves the deadline on
+    *        according to the mode and catch up policy.
+    *
+    *  Call this instead of onExpire() to run the periodic work inline:
+    *  @code
+    *  while (timer.poll()) work();  // runs all missed ticks with CatchUp::Burst
+    *  @endcode
+    *
+    * @return rep 0 if the timer is not due, otherwise the number of periods
+    *         this firing stands for: always 1 except with CatchUp::Coalesce
+    */
+  rep poll() {
+    rep t = now();
+    rep late = t - deadline_;
+    if (late > kMaxLateness) return 0;
+    jitter_.add(late);
+    fired_++;
+
+    if (mode_ == PeriodicMode::FixedDelay) {
+      deadline_ = t + period_;
+      lastTicks_ = 1;
+      return lastTicks_;
+    }
+
+    rep behind = late / period_;
+    switch (catchUp_) {
+    case CatchUp::Burst:
+      deadline_ += period_;
+      lastTicks_ = 1;
+      break;
+    case CatchUp::Coalesce:
+      deadline_ += (behind + 1) * period_;
+      missed_ += (uint32_t)behind;
+      lastTicks_ = behind + 1;
+      break;
+    case CatchUp::Skip:
+    default:
+      deadline_ += (behind + 1) * period_;
+      missed_ += (uint32_t)behind;
+      lastTicks_ = 1;
+      break;
+    }
+    return lastTicks_;
+  }
+
+  /**
+    * @brief Runs cb(args...) if the timer is due.  With CatchUp::Burst the
+    *        callback runs once for every deadline that was due on entry.
+    *
+    *  Use lastTickCount() inside the callback to see how many periods a
+    *  coalesced call stands for.
+    */
+  template<typename Functor, typename... ArgTypes>
+  void onExpire(Functor cb, ArgTypes... args) {
+    rep due = pendingTicks();
+    if (mode_ != PeriodicMode::FixedRate || catchUp_ != CatchUp::Burst) due = due ? 1 : 0;
+    for (; due > 0; due--) {
+      rep start = now();
+      if (!poll()) break;
+      cb(args...);
+      rep end = now();
+      if ((rep)(end - start) > period_) overruns_++;
+      if (mode_ == PeriodicMode::FixedDelay) deadline_ = end + period_;
+    }
+  }
+
+  /**
+    * @brief The number of periods the most recent firing stood for
+    */
+  rep lastTickCount() const { return lastTicks_; }
+
+  /**
+    * @brief Times the timer has fired
+    */
+  uint32_t firedCount() const { return fired_; }
+
+  /**
+    * @brief Deadlines that passed without a call of their own, dropped by
+    *        CatchUp::Skip or folded into one call by CatchUp::Coalesce
+    */
+  uint32_t missedTicks() const { return missed_; }
+
+  /**
+    * @brief Callbacks run by onExpire() that took longer than one period
+    */
+  uint32_t overruns() const { return overruns_; }
+
+  /**
+    * @brief How late each firing was relative to its deadline
+    */
+  const JitterStats& jitter() const { return jitter_; }
+
+  void resetStats() {
+    fired_ = 0;
+    missed_ = 0;
+    overruns_ = 0;
+    jitter_.reset();
+  }
+
+protected:
+  rep deadline_;
+  rep period_;
+  PeriodicMode mode_;
+  CatchUp catchUp_;
+  rep lastTicks_;
+  uint32_t fired_;
+  uint32_t missed_;
+  uint32_t overruns_;
+  JitterStats jitter_;
+};
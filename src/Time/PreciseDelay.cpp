@@ -0,0 +1,179 @@
+#include "PreciseDelay.h"
+#include "SimulatedClock.h"
+#include <string.h>
+
+#if !defined(RT_HAS_ARDUINO) && !JUCE_MODULE_AVAILABLE_juce_core && (defined(__unix__) || defined(__APPLE__))
+#define RT_PRECISE_DELAY_POSIX 1
+#include <time.h>
+#include <errno.h>
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
+uint32_t PreciseDelay::spinThresholdNs_ = PreciseDelay::kDefaultSpinThresholdNs;
+bool PreciseDelay::recording_ = false;
+DelayStats PreciseDelay::stats_;
+
+static inline void cpuRelax() {
+#if defined(__x86_64__) || defined(__i386__)
+  _mm_pause();
+#elif defined(__aarch64__)
+  asm volatile("yield");
+#endif
+}
+
+static inline int bitLength(uint64_t v) {
+  int n = 0;
+  while (v) {
+    v >>= 1;
+    n++;
+  }
+  return n;
+}
+
+void DelayStats::reset() {
+  count_ = 0;
+  min_ = 0;
+  max_ = 0;
+  sum_ = 0;
+  memset(buckets_, 0, sizeof(buckets_));
+}
+
+void DelayStats::record(uint64_t overshootNs) {
+  if (count_ == 0 || overshootNs < min_) min_ = overshootNs;
+  if (overshootNs > max_) max_ = overshootNs;
+  count_++;
+  sum_ += overshootNs;
+  int bucket = bitLength(overshootNs);
+  buckets_[bucket < kBuckets ? bucket : kBuckets - 1]++;
+}
+
+uint64_t DelayStats::percentile(double percent) const {
+  if (count_ == 0) return 0;
+  uint64_t target = (uint64_t)(count_ * percent / 100.0 + 0.5);
+  if (target == 0) target = 1;
+  uint64_t seen = 0;
+  for (int i = 0; i < kBuckets; i++) {
+    seen += buckets_[i];
+    if (seen >= target) {
+      uint64_t upper = i == 0 ? 0 : (1ull << i) - 1;
+      return upper < max_ ? upper : max_;
+    }
+  }
+  return max_;
+}
+
+size_t DelayStats::printTo(Print& p) const {
+  size_t n = 0;
+  n += p.print("n=");
+  n += p.print((unsigned long)count_);
+  n += p.print(" min=");
+  n += p.print((unsigned long)min_);
+  n += p.print(" mean=");
+  n += p.print((unsigned long)mean());
+  n += p.print(" p50=");
+  n += p.print((unsigned long)percentile(50));
+  n += p.print(" p90=");
+  n += p.print((unsigned long)percentile(90));
+  n += p.print(" p99=");
+  n += p.print((unsigned long)percentile(99));
+  n += p.print(" max=");
+  n += p.print((unsigned long)max_);
+  n += p.print(" ns");
+  return n;
+}
+
+// The OS sleep; wakes at deadlineNs or, usually, somewhat after it
+void PreciseDelay::sleepUntil(uint64_t deadlineNs) {
+#if RT_SIMULATED_CLOCK
+  if (SimulatedClock* sim = SimulatedClock::current()) {
+    sim->advanceTo(deadlineNs);
+    return;
+  }
+#endif
+#if RT_PRECISE_DELAY_POSIX && defined(__linux__)
+  struct timespec ts;
+  ts.tv_sec = (time_t)(deadlineNs / 1000000000ull);
+  ts.tv_nsec = (long)(deadlineNs % 1000000000ull);
+  while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, nullptr) == EINTR) {}
+#elif RT_PRECISE_DELAY_POSIX
+  uint64_t now = nanos();
+  if (deadlineNs <= now) return;
+  uint64_t ns = deadlineNs - now;
+  struct timespec ts;
+  ts.tv_sec = (time_t)(ns / 1000000000ull);
+  ts.tv_nsec = (long)(ns % 1000000000ull);
+  while (nanosleep(&ts, &ts) == -1 && errno == EINTR) {}
+#else
+  // Millisecond sleeps only; the spin covers the remainder
+  uint64_t now = nanos();
+  if (deadlineNs <= now) return;
+  uint32_t ms = (uint32_t)((deadlineNs - now) / 1000000ull);
+  if (ms > 0) delay(ms);
+#endif
+}
+
+// Sleeps for the bulk of the wait, spins for the rest; returns the wake time
+uint64_t PreciseDelay::wait(uint64_t deadlineNs) {
+#if RT_SIMULATED_CLOCK
+  // Simulated time does not move while spinning
+  if (SimulatedClock* sim = SimulatedClock::current()) {
+    sim->advanceTo(deadlineNs);
+    return sim->nanos();
+  }
+#endif
+  uint64_t now = nanos();
+  if (deadlineNs > now + spinThresholdNs_) sleepUntil(deadlineNs - spinThresholdNs_);
+  while ((now = nanos()) < deadlineNs) cpuRelax();
+  return now;
+}
+
+void PreciseDelay::delayUntil(uint64_t deadlineNs) {
+  uint64_t woke = wait(deadlineNs);
+  if (recording_) stats_.record(woke - deadlineNs);
+}
+
+void PreciseDelay::delayNanos(uint64_t ns) {
+  delayUntil(nanos() + ns);
+}
+
+void PreciseDelay::measure(uint64_t ns, uint32_t iterations, DelayStats& out) {
+  for (uint32_t i = 0; i < iterations; i++) {
+    uint64_t deadline = nanos() + ns;
+    out.record(wait(deadline) - deadline);
+  }
+}
+
+uint32_t PreciseDelay::calibrate(uint32_t samples, DelayStats* stats) {
+  static constexpr uint32_t kMaxSamples = 128;
+  static constexpr uint64_t kSampleNs = 1000000ull;
+  static constexpr uint64_t kMaxThresholdNs = 20000000ull;
+  uint64_t oversleep[kMaxSamples];
+  if (samples == 0) samples = 1;
+  if (samples > kMaxSamples) samples = kMaxSamples;
+
+  for (uint32_t i = 0; i < samples; i++) {
+    uint64_t deadline = nanos() + kSampleNs;
+    sleepUntil(deadline);
+    uint64_t now = nanos();
+    uint64_t late = now > deadline ? now - deadline : 0;
+    if (stats != nullptr) stats->record(late);
+    // Insertion sort, the sample count is small
+    uint32_t j = i;
+    while (j > 0 && oversleep[j - 1] > late) {
+      oversleep[j] = oversleep[j - 1];
+      j--;
+    }
+    oversleep[j] = late;
+  }
+
+  // Cover the 95th percentile with a 25% margin; rarer outliers (preemption)
+  // are not worth spinning for on every call.
+  uint64_t p95 = oversleep[(samples * 95) / 100];
+  uint64_t threshold = p95 + p95 / 4 + 5000ull;
+  if (threshold > kMaxThresholdNs) threshold = kMaxThresholdNs;
+  spinThresholdNs_ = (uint32_t)threshold;
+  return spinThresholdNs_;
+}
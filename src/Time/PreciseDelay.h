@@ -0,0 +1,112 @@
+#pragma once
+
+#include "./TimeDeps.h"
+
+/**
+  * @brief Distribution of how much longer than requested delays took, in
+  *        nanoseconds.  Buckets are powers of two, so percentiles are upper
+  *        bounds within a factor of two.
+  */
+class DelayStats : public Printable
+{
+public:
+  static constexpr int kBuckets = 40; //!< Bucket i holds overshoots below 2^i ns, the last one everything above
+
+  DelayStats() { reset(); }
+
+  void reset();
+  void record(uint64_t overshootNs);
+
+  uint32_t count() const { return count_; }
+  uint64_t min() const { return min_; }
+  uint64_t max() const { return max_; }
+  uint64_t mean() const { return count_ ? sum_ / count_ : 0; }
+
+  /**
+    * @brief Upper bound of the given percentile, clamped to max()
+    *
+    * @param percent 0 to 100
+    */
+  uint64_t percentile(double percent) const;
+
+  uint32_t bucketCount(int bucket) const { return buckets_[bucket]; }
+
+  /**
+    * @brief Prints a one line summary: count, min, mean, p50, p90, p99, max
+    */
+  size_t printTo(Print& p) const override;
+
+protected:
+  uint32_t count_;
+  uint64_t min_;
+  uint64_t max_;
+  uint64_t sum_;
+  uint32_t buckets_[kBuckets];
+};
+
+/**
+  * @brief Delays accurate to about a microsecond without burning a core for
+  *        the whole wait.
+  *
+  *  A delay sleeps in the OS until spinThreshold() before the deadline and
+  *  spins on nanos() for the rest.  OS sleeps wake late by a host dependent
+  *  amount (timer slack, scheduler tick), so the threshold should be measured
+  *  with calibrate() once at startup; until then a conservative default is
+  *  used.  delayMicroseconds() uses this on hosted builds.
+  *
+  *  With recording enabled every delay's overshoot is added to stats().
+  *  Recording and the threshold are process wide and not synchronised; set
+  *  them up before starting threads.
+  */
+class PreciseDelay
+{
+public:
+  static constexpr uint32_t kDefaultSpinThresholdNs = 100000;
+
+  static void delayNanos(uint64_t ns);
+
+  static void delayMicros(uint32_t us) { delayNanos((uint64_t)us * 1000ull); }
+
+  /**
+    * @brief Delays until nanos() reaches deadline
+    */
+  static void delayUntil(uint64_t deadlineNs);
+
+  /**
+    * @brief Measures how late the OS sleep wakes and sets the spin threshold
+    *        to the 95th percentile of the oversleep plus 25% plus 5 us,
+    *        capped at 20 ms.  Rarer, longer wakeups (preemption) are left
+    *        uncovered rather than spun for on every delay.
+    *
+    * @param samples Number of test sleeps, each around a millisecond; at
+    *        most 128
+    * @param stats If given, receives the measured oversleep distribution
+    * @return uint32_t The new threshold in nanoseconds
+    */
+  static uint32_t calibrate(uint32_t samples = 32, DelayStats* stats = nullptr);
+
+  static uint32_t spinThreshold() { return spinThresholdNs_; }
+  static void setSpinThreshold(uint32_t ns) { spinThresholdNs_ = ns; }
+
+  static void setRecording(bool enabled) { recording_ = enabled; }
+  static bool isRecording() { return recording_; }
+
+  /**
+    * @brief Overshoot of the delays run while recording
+    */
+  static DelayStats& stats() { return stats_; }
+
+  /**
+    * @brief Runs a delay of the given length repeatedly and collects the
+    *        overshoot, without touching stats()
+    */
+  static void measure(uint64_t ns, uint32_t iterations, DelayStats& out);
+
+protected:
+  static uint32_t spinThresholdNs_;
+  static bool recording_;
+  static DelayStats stats_;
+
+  static void sleepUntil(uint64_t deadlineNs);
+  static uint64_t wait(uint64_t deadlineNs);
+};
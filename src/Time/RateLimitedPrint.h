@@ -0,0 +1,119 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./RateLimiter.h"
+
+/**
+  * @brief What RateLimitedPrint does with lines over the budget
+  */
+enum class SuppressMode {
+  Drop,      //!< Discard them silently; only the counters record them
+  Summarize, //!< Discard them and print "... N lines suppressed" before the next line let through
+};
+
+/**
+  * @brief A Print adapter that passes whole lines on to another Print while
+  *        a rate limiter allows, and drops the rest.
+  *
+  *  Every line takes one token from the limiter when its first byte is
+  *  written, and is passed on or dropped as a whole, so the output never
+  *  contains partial lines.  Dropping a line costs a scan for its newline,
+  *  so a log storm cannot hold up the loop that writes it on a slow Print.
+  *
+  *  The limiter is not owned and can be shared by several adapters, e.g.
+  *  to give all diagnostic output one budget.  The adapter itself, like any
+  *  Print, is for one writer at a time.
+  *
+  * @code
+  * TokenBucket<> budget(20, 1000, 50);
+  * RateLimitedPrint<TokenBucket<>> log(Serial, budget);
+  * log.println("sensor timeout");
+  * @endcode
+  *
+  * @tparam Limiter TokenBucket, SlidingWindowLimiter or any type with tryAcquire(uint32_t)
+  */
+template<typename Limiter>
+class RateLimitedPrint : public Print
+{
+public:
+  RateLimitedPrint(Print& out, Limiter& limiter, SuppressMode mode = SuppressMode::Summarize) :
+    out_(out), limiter_(limiter), mode_(mode), atLineStart_(true), passing_(false),
+    passedLines_(0), suppressedLines_(0), suppressedBytes_(0), unreported_(0) {};
+
+  /**
+    * @return size_t Always 1: dropped bytes are not write errors
+    */
+  size_t write(uint8_t c) override {
+    if (atLineStart_) beginLine();
+    if (passing_) out_.write(c);
+    else suppressedBytes_++;
+    if (c == '\n') atLineStart_ = true;
+    return 1;
+  }
+
+  size_t write(const uint8_t* buffer, size_t size) override {
+    size_t done = 0;
+    while (done < size) {
+      if (atLineStart_) beginLine();
+      const uint8_t* end = (const uint8_t*)memchr(buffer + done, '\n', size - done);
+      size_t length = end ? (size_t)(end - (buffer + done)) + 1 : size - done;
+      if (passing_) out_.write(buffer + done, length);
+      else suppressedBytes_ += length;
+      done += length;
+      atLineStart_ = end != nullptr;
+    }
+    return size;
+  }
+
+  int availableForWrite() override { return out_.availableForWrite(); }
+
+  void flush() override { out_.flush(); }
+
+  void setMode(SuppressMode mode) { mode_ = mode; }
+  SuppressMode mode() const { return mode_; }
+
+  uint32_t passedLines() const { return passedLines_; }
+  uint32_t suppressedLines() const { return suppressedLines_; }
+  uint32_t suppressedBytes() const { return suppressedBytes_; }
+
+  /**
+    * @brief Lines dropped since the last summary was printed
+    */
+  uint32_t unreportedLines() const { return unreported_; }
+
+  void resetCounters() {
+    passedLines_ = 0;
+    suppressedLines_ = 0;
+    suppressedBytes_ = 0;
+    unreported_ = 0;
+  }
+
+protected:
+  Print& out_;
+  Limiter& limiter_;
+  SuppressMode mode_;
+  bool atLineStart_;
+  bool passing_;
+  uint32_t passedLines_;
+  uint32_t suppressedLines_;
+  uint32_t suppressedBytes_;
+  uint32_t unreported_;
+
+  void beginLine() {
+    atLineStart_ = false;
+    passing_ = limiter_.tryAcquire(1);
+    if (!passing_) {
+      suppressedLines_++;
+      unreported_++;
+      return;
+    }
+    passedLines_++;
+    if (unreported_ && mode_ == SuppressMode::Summarize) {
+      // The summary rides on the line's token
+      out_.print("... ");
+      out_.print((unsigned long)unreported_);
+      out_.println(" lines suppressed");
+    }
+    unreported_ = 0;
+  }
+};
@@ -0,0 +1,220 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./Clocks.h"
+#include <atomic>
+
+/**
+  * @brief Token bucket rate limiter: rate tokens per period on average, with
+  *        bursts of up to capacity.
+  *
+  *  The whole state, the time of the last refill and the credit left, is
+  *  one 64 bit word, so tryAcquire() is a single compare-and-swap and may
+  *  be called from any thread.  Credit is kept in integer units of
+  *  1 / period token, so no rate is rounded.
+  *
+  *  Times are the Clock's ticks truncated to 32 bits.  A bucket left alone
+  *  for more than a quarter of that range (about 12 days with MillisClock,
+  *  18 minutes with MicrosClock) is treated as full.  Idle time is only
+  *  known modulo 2^32, so a bucket idle for within kMaxLag ticks of a whole
+  *  multiple of the range keeps the credit it had.
+  *
+  * @code
+  * TokenBucket<> logLimit(10, 1000, 20);   // 10 per second, bursts of 20
+  * if (logLimit.tryAcquire()) Serial.println(message);
+  * @endcode
+  *
+  * @tparam Clock The clock policy (see Time/Clocks.h)
+  */
+template<typename Clock = MillisClock>
+class TokenBucket
+{
+public:
+  static constexpr uint32_t kMaxLag = 0x10000; //!< How far behind the stored time a reading may be
+
+  /**
+    * @param rate Tokens added every period
+    * @param period The refill period in clock ticks
+    * @param capacity The largest burst; capacity * period must be below 2^32
+    */
+  TokenBucket(uint32_t rate, uint32_t period, uint32_t capacity) { configure(rate, period, capacity); }
+
+  TokenBucket(const TokenBucket&) = delete;
+  TokenBucket& operator=(const TokenBucket&) = delete;
+
+  /**
+    * @brief Changes the parameters and fills the bucket; not safe against
+    *        concurrent tryAcquire() calls
+    */
+  void configure(uint32_t rate, uint32_t period, uint32_t capacity) {
+    rate_ = rate;
+    period_ = period ? period : 1;
+    uint64_t maxCredit = (uint64_t)capacity * period_;
+    maxCredit_ = maxCredit > 0xffffffffull ? 0xffffffffu : (uint32_t)maxCredit;
+    reset();
+  }
+
+  /**
+    * @brief Fills the bucket
+    */
+  void reset() {
+    state_.store(pack((uint32_t)Clock::now(), maxCredit_), std::memory_order_relaxed);
+  }
+
+  /**
+    * @brief Takes n tokens if they are all available
+    *
+    * @return false If fewer than n tokens are available; nothing is taken
+    */
+  bool tryAcquire(uint32_t n = 1) {
+    uint64_t cost = (uint64_t)n * period_;
+    uint64_t old = state_.load(std::memory_order_relaxed);
+    for (;;) {
+      uint32_t now = (uint32_t)Clock::now();
+      uint32_t last;
+      uint64_t credit = refill(old, now, last);
+      if (credit < cost) return false;
+      if (state_.compare_exchange_weak(old, pack(last, (uint32_t)(credit - cost)),
+        std::memory_order_relaxed, std::memory_order_relaxed)) return true;
+    }
+  }
+
+  /**
+    * @brief Whole tokens available now
+    */
+  uint32_t available() const {
+    uint32_t last;
+    return (uint32_t)(refill(state_.load(std::memory_order_relaxed), (uint32_t)Clock::now(), last) / period_);
+  }
+
+  uint32_t rate() const { return rate_; }
+  uint32_t period() const { return period_; }
+  uint32_t capacity() const { return maxCredit_ / period_; }
+
+protected:
+  std::atomic<uint64_t> state_; //!< Last refill time in the high half, credit in the low half
+  uint32_t rate_;
+  uint32_t period_;
+  uint32_t maxCredit_;
+
+  static uint64_t pack(uint32_t time, uint32_t credit) {
+    return ((uint64_t)time << 32) | credit;
+  }
+
+  uint64_t refill(uint64_t state, uint32_t now, uint32_t& last) const {
+    last = (uint32_t)(state >> 32);
+    uint64_t credit = (uint32_t)state;
+    uint32_t elapsed = now - last;
+    if (elapsed > 0u - kMaxLag) {
+      // Slightly behind: another thread stored a time read just after ours,
+      // or on a core whose clock runs a little ahead
+      return credit;
+    }
+    last = now;
+    if (elapsed >= 0x40000000u) return maxCredit_;
+    credit += (uint64_t)elapsed * rate_;
+    return credit > maxCredit_ ? maxCredit_ : credit;
+  }
+};
+
+/**
+  * @brief Sliding window rate limiter: at most limit events in any window
+  *        of the given length, approximately.
+  *
+  *  Events are counted per fixed window, and the count of the previous
+  *  window is weighted by how much of it still overlaps the sliding window
+  *  ending now.  This smooths the doubled bursts a fixed window allows at
+  *  its edges.  State is one 64 bit word updated with compare-and-swap.
+  *
+  *  Like TokenBucket, times are the Clock's ticks truncated to 32 bits and
+  *  compared by wrap-safe subtraction, so the limiter keeps working when
+  *  millis() or micros() wraps, and after any idle time short of the whole
+  *  32 bit range.  Windows are limited to kMaxWindow ticks.
+  *
+  * @tparam Clock The clock policy (see Time/Clocks.h)
+  */
+template<typename Clock = MillisClock>
+class SlidingWindowLimiter
+{
+public:
+  static constexpr uint32_t kMaxLimit = 0xffff;
+  static constexpr uint32_t kMaxWindow = 0x20000000;
+  static constexpr uint32_t kMaxLag = 0x10000; //!< How far behind the window start a reading may be
+
+  /**
+    * @param limit Events allowed per window, at most kMaxLimit
+    * @param window The window length in clock ticks, at most kMaxWindow
+    */
+  SlidingWindowLimiter(uint32_t limit, uint32_t window) { configure(limit, window); }
+
+  SlidingWindowLimiter(const SlidingWindowLimiter&) = delete;
+  SlidingWindowLimiter& operator=(const SlidingWindowLimiter&) = delete;
+
+  void configure(uint32_t limit, uint32_t window) {
+    limit_ = limit > kMaxLimit ? kMaxLimit : limit;
+    window_ = window == 0 ? 1 : window > kMaxWindow ? kMaxWindow : window;
+    reset();
+  }
+
+  void reset() {
+    state_.store(pack((uint32_t)Clock::now(), 0, 0), std::memory_order_relaxed);
+  }
+
+  /**
+    * @return false If n more events would exceed the limit; nothing is counted
+    */
+  bool tryAcquire(uint32_t n = 1) {
+    uint64_t old = state_.load(std::memory_order_relaxed);
+    for (;;) {
+      uint32_t now = (uint32_t)Clock::now();
+      uint32_t start, position, previous, current;
+      advance(old, now, start, position, previous, current);
+      uint64_t weighted = (uint64_t)previous * (window_ - position) + (uint64_t)(current + n) * window_;
+      if (current + n > kMaxLimit || weighted > (uint64_t)limit_ * window_) return false;
+      if (state_.compare_exchange_weak(old, pack(start, previous, current + n),
+        std::memory_order_relaxed, std::memory_order_relaxed)) return true;
+    }
+  }
+
+  uint32_t limit() const { return limit_; }
+  uint32_t window() const { return window_; }
+
+protected:
+  std::atomic<uint64_t> state_; //!< Current window start time, previous window count, current window count
+  uint32_t limit_;
+  uint32_t window_;
+
+  static uint64_t pack(uint32_t start, uint32_t previous, uint32_t current) {
+    return ((uint64_t)start << 32) | ((uint64_t)previous << 16) | current;
+  }
+
+  // Moves the stored window forward to the one holding now; position is
+  // now's offset into it
+  void advance(uint64_t state, uint32_t now, uint32_t& start, uint32_t& position,
+    uint32_t& previous, uint32_t& current) const {
+    start = (uint32_t)(state >> 32);
+    previous = (uint32_t)(state >> 16) & 0xffff;
+    current = (uint32_t)state & 0xffff;
+    uint32_t elapsed = now - start;
+    if (elapsed > 0u - kMaxLag) {
+      // Slightly behind: another thread started a window at a time read
+      // just after ours
+      position = 0;
+    }
+    else if (elapsed < window_) {
+      position = elapsed;
+    }
+    else if (elapsed < 2 * window_) {
+      start += window_;
+      position = elapsed - window_;
+      previous = current;
+      current = 0;
+    }
+    else {
+      position = elapsed % window_;
+      start = now - position;
+      previous = 0;
+      current = 0;
+    }
+  }
+};
@@ -0,0 +1,26 @@
+#include "SimulatedClock.h"
+
+#if RT_SIMULATED_CLOCK
+
+thread_local SimulatedClock* SimulatedClock::threadClock_ = nullptr;
+std::atomic<SimulatedClock*> SimulatedClock::globalClock_(nullptr);
+
+SimulatedClock::~SimulatedClock() {
+  uninstall();
+}
+
+void SimulatedClock::install() {
+  threadClock_ = this;
+}
+
+void SimulatedClock::installGlobal() {
+  globalClock_.store(this, std::memory_order_release);
+}
+
+void SimulatedClock::uninstall() {
+  if (threadClock_ == this) threadClock_ = nullptr;
+  SimulatedClock* expected = this;
+  globalClock_.compare_exchange_strong(expected, nullptr, std::memory_order_acq_rel);
+}
+
+#endif
@@ -0,0 +1,179 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./Clocks.h"
+#include "./TimerWheel.h"
+#include <atomic>
+
+/*
+  The simulated clock replaces the platform timebase on host builds (JUCE,
+  Windows and POSIX).  Define RT_SIMULATED_CLOCK to 0 to compile the hooks
+  out of nanos() and delay().  On Arduino the timebase belongs to the core
+  and cannot be replaced.
+*/
+#ifndef RT_SIMULATED_CLOCK
+#if RT_HAS_ARDUINO
+#define RT_SIMULATED_CLOCK 0
+#else
+#define RT_SIMULATED_CLOCK 1
+#endif
+#endif
+
+#if RT_SIMULATED_CLOCK
+
+/**
+  * @brief A virtual timebase for tests: while installed, millis(), micros(),
+  *        their 64 bit variants and nanos() return the simulated time, and
+  *        delay(), delayMicroseconds() and PreciseDelay advance it instead
+  *        of sleeping.
+  *
+  *  Time only moves when the test moves it, by a fixed step or straight to
+  *  the next timer deadline, so hours of timer activity run in as long as
+  *  the callbacks take, and every run is the same.
+  *
+  *  A clock installed with install() is seen by the installing thread
+  *  only, so tests on different threads each get their own.  A clock
+  *  installed with installGlobal() is seen by every thread that has no
+  *  clock of its own, for code under test that runs its own threads.  A
+  *  TimerService loop under a SimulatedClock polls it every millisecond of
+  *  real time instead of arming its timerfd.
+  *
+  *  To cover the 32 bit wrap of millis() or micros(), start the clock just
+  *  before kMillisWrapNanos or kMicrosWrapNanos.
+  *
+  * @code
+  * SimulatedClock clock(SimulatedClock::kMillisWrapNanos - 60000000000ull); // a minute before millis() wraps
+  * clock.install();
+  * TimerWheel<> wheel;
+  * ... start timers ...
+  * clock.runFor(wheel, 3600000);   // one simulated hour, deadline to deadline
+  * @endcode
+  */
+class SimulatedClock
+{
+public:
+  static constexpr uint64_t kMillisWrapNanos = 4294967296ull * 1000000ull; //!< Where millis() wraps to 0
+  static constexpr uint64_t kMicrosWrapNanos = 4294967296ull * 1000ull;    //!< Where micros() wraps to 0
+
+  SimulatedClock(uint64_t startNanos = 0) : nanos_(startNanos) {};
+
+  /**
+    * @brief Uninstalls the clock from this thread and globally, if installed
+    */
+  ~SimulatedClock();
+
+  SimulatedClock(const SimulatedClock&) = delete;
+  SimulatedClock& operator=(const SimulatedClock&) = delete;
+
+  uint64_t nanos() const { return nanos_.load(std::memory_order_acquire); }
+
+  /**
+    * @brief Sets the time; moving it backwards is allowed but code that
+    *        relies on a monotonic clock will misbehave
+    */
+  void setNanos(uint64_t ns) { nanos_.store(ns, std::memory_order_release); }
+
+  void advanceNanos(uint64_t ns) { nanos_.fetch_add(ns, std::memory_order_acq_rel); }
+  void advanceMicros(uint64_t us) { advanceNanos(us * 1000ull); }
+  void advanceMillis(uint64_t ms) { advanceNanos(ms * 1000000ull); }
+
+  /**
+    * @brief Advances the time to ns, if it is not already later
+    */
+  void advanceTo(uint64_t ns) {
+    uint64_t now = nanos_.load(std::memory_order_relaxed);
+    while (now < ns && !nanos_.compare_exchange_weak(now, ns, std::memory_order_acq_rel)) {}
+  }
+
+  /**
+    * @brief Advances the time by a number of a clock policy's ticks
+    */
+  template<typename Clock>
+  void advanceTicks(uint64_t ticks) {
+    advanceNanos((ticks / Clock::kTicksPerSecond) * 1000000000ull +
+      ((ticks % Clock::kTicksPerSecond) * 1000000000ull) / Clock::kTicksPerSecond);
+  }
+
+  /**
+    * @brief Moves the time to the wheel's next event, if any, and advances
+    *        the wheel
+    *
+    * @return size_t The number of callbacks run
+    */
+  template<typename Clock>
+  size_t advanceToNextEvent(TimerWheel<Clock>& wheel) {
+    uint32_t when;
+    if (!wheel.nextEvent(when)) return 0;
+    uint32_t ahead = when - (uint32_t)Clock::now();
+    if (ahead < 0x80000000u) advanceTicks<Clock>(ahead);
+    return wheel.tick();
+  }
+
+  /**
+    * @brief Runs the wheel for a span of simulated time, jumping from one
+    *        event to the next
+    *
+    * @param ticks The span in the wheel's clock ticks, below 2^31
+    * @return size_t The number of callbacks run
+    */
+  template<typename Clock>
+  size_t runFor(TimerWheel<Clock>& wheel, uint32_t ticks) {
+    uint32_t end = (uint32_t)Clock::now() + ticks;
+    size_t fired = 0;
+    uint32_t when;
+    while (wheel.nextEvent(when) && (int32_t)(end - when) >= 0) fired += advanceToNextEvent(wheel);
+    uint32_t rest = end - (uint32_t)Clock::now();
+    if (rest < 0x80000000u) advanceTicks<Clock>(rest);
+    return fired + wheel.tick();
+  }
+
+  /**
+    * @brief Makes this the calling thread's clock
+    */
+  void install();
+
+  /**
+    * @brief Makes this the clock of every thread without one of its own
+    */
+  void installGlobal();
+
+  /**
+    * @brief Restores the real clock, for this thread or globally, whichever
+    *        this clock is installed as
+    */
+  void uninstall();
+
+  /**
+    * @brief The clock in effect for the calling thread, nullptr for the
+    *        real one
+    */
+  static SimulatedClock* current() {
+    SimulatedClock* clock = threadClock_;
+    return clock != nullptr ? clock : globalClock_.load(std::memory_order_acquire);
+  }
+
+protected:
+  std::atomic<uint64_t> nanos_;
+
+  static thread_local SimulatedClock* threadClock_;
+  static std::atomic<SimulatedClock*> globalClock_;
+};
+
+/**
+  * @brief Installs a SimulatedClock for the calling thread for the lifetime
+  *        of the scope
+  */
+class SimulatedClockScope
+{
+public:
+  SimulatedClockScope(SimulatedClock& clock) : clock_(clock) { clock_.install(); }
+  ~SimulatedClockScope() { clock_.uninstall(); }
+
+  SimulatedClockScope(const SimulatedClockScope&) = delete;
+  SimulatedClockScope& operator=(const SimulatedClockScope&) = delete;
+
+protected:
+  SimulatedClock& clock_;
+};
+
+#endif
@@ -0,0 +1,6 @@
+#ifndef _RT_CORE_LIB_TIME_DEPS_H_
+#define _RT_CORE_LIB_TIME_DEPS_H_
+
+#include "../RTCorePlatformDeps.h"
+
+#endif
@@ -0,0 +1,252 @@
+#include "TimerService.h"
+#include "SimulatedClock.h"
+
+#if RT_HAS_TIMER_SERVICE
+
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+#include <errno.h>
+#include <string.h>
+
+static bool watchFd(int epollFd, int op, int fd, uint32_t events, void* ptr) {
+  struct epoll_event ev;
+  memset(&ev, 0, sizeof(ev));
+  ev.events = events;
+  ev.data.ptr = ptr;
+  return epoll_ctl(epollFd, op, fd, &ev) == 0;
+}
+
+static void drainCounter(int fd) {
+  uint64_t value;
+  while (read(fd, &value, sizeof(value)) == (ssize_t)sizeof(value)) {}
+}
+
+TimerService::TimerService() :
+  epollFd_(-1), armed_(false), armedFor_(0), stopRequested_(false),
+  postHead_(0), postTail_(0), batch_(nullptr), batchSize_(0) {
+  for (size_t i = 0; i < kPostQueueSize; i++) {
+    posts_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+}
+
+TimerService::~TimerService() {
+  end();
+}
+
+bool TimerService::begin() {
+  if (isOpen()) return true;
+  epollFd_ = epoll_create1(EPOLL_CLOEXEC);
+  timerWatch_.fd_ = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+  wakeWatch_.fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+  if (epollFd_ < 0 || timerWatch_.fd_ < 0 || wakeWatch_.fd_ < 0 ||
+    !watchFd(epollFd_, EPOLL_CTL_ADD, timerWatch_.fd_, EPOLLIN, &timerWatch_) ||
+    !watchFd(epollFd_, EPOLL_CTL_ADD, wakeWatch_.fd_, EPOLLIN, &wakeWatch_)) {
+    end();
+    return false;
+  }
+  armed_ = false;
+  return true;
+}
+
+void TimerService::end() {
+  if (timerWatch_.fd_ >= 0) close(timerWatch_.fd_);
+  if (wakeWatch_.fd_ >= 0) close(wakeWatch_.fd_);
+  if (epollFd_ >= 0) close(epollFd_);
+  timerWatch_.fd_ = -1;
+  wakeWatch_.fd_ = -1;
+  epollFd_ = -1;
+  armed_ = false;
+}
+
+void TimerService::startFrom(uint32_t base, WheelTimer& timer, uint32_t delay, uint32_t period) {
+  // The wheel's time only moves when the loop runs; count from base instead
+  int32_t remaining = (int32_t)(base + delay - wheel_.now());
+  wheel_.start(timer, remaining > 0 ? (uint32_t)remaining : 1, period);
+}
+
+void TimerService::start(WheelTimer& timer, uint32_t delayMs, uint32_t periodMs) {
+  startFrom(millis(), timer, delayMs, periodMs);
+}
+
+void TimerService::stop(WheelTimer& timer) {
+  wheel_.stop(timer);
+}
+
+// Bounded MPSC queue after Dmitry Vyukov: each slot's sequence number says
+// whether it is free for the producer at that position or full for the
+// consumer, so producers only contend on the head counter.
+bool TimerService::enqueue(PostOp op, WheelTimer& timer, uint32_t delay, uint32_t period) {
+  size_t pos = postHead_.load(std::memory_order_relaxed);
+  PostSlot* slot;
+  for (;;) {
+    slot = &posts_[pos & (kPostQueueSize - 1)];
+    size_t seq = slot->sequence.load(std::memory_order_acquire);
+    intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+    if (diff == 0) {
+      if (postHead_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+    }
+    else if (diff < 0) {
+      return false;
+    }
+    else {
+      pos = postHead_.load(std::memory_order_relaxed);
+    }
+  }
+  slot->timer = &timer;
+  slot->issued = millis();
+  slot->delay = delay;
+  slot->period = period;
+  slot->op = op;
+  slot->sequence.store(pos + 1, std::memory_order_release);
+  wake();
+  return true;
+}
+
+bool TimerService::post(WheelTimer& timer, uint32_t delayMs, uint32_t periodMs) {
+  return enqueue(PostOp::Start, timer, delayMs, periodMs);
+}
+
+bool TimerService::postStop(WheelTimer& timer) {
+  return enqueue(PostOp::Stop, timer, 0, 0);
+}
+
+void TimerService::drainPosts() {
+  for (;;) {
+    PostSlot& slot = posts_[postTail_ & (kPostQueueSize - 1)];
+    if (slot.sequence.load(std::memory_order_acquire) != postTail_ + 1) break;
+    if (slot.op == PostOp::Start) startFrom(slot.issued, *slot.timer, slot.delay, slot.period);
+    else wheel_.stop(*slot.timer);
+    slot.sequence.store(postTail_ + kPostQueueSize, std::memory_order_release);
+    postTail_++;
+  }
+}
+
+void TimerService::wake() {
+  uint64_t one = 1;
+  if (write(wakeWatch_.fd_, &one, sizeof(one)) < 0) {
+    // EAGAIN means the counter is saturated, the loop is waking anyway
+  }
+}
+
+bool TimerService::isSimulated() const {
+#if RT_SIMULATED_CLOCK
+  return SimulatedClock::current() != nullptr;
+#else
+  return false;
+#endif
+}
+
+// millis() counts CLOCK_MONOTONIC milliseconds on Linux, so the wheel's next
+// event maps to an absolute timerfd deadline on the millisecond boundary.
+// Under a SimulatedClock it does not, so the timerfd stays disarmed and
+// runOnce() polls the simulated time instead.
+void TimerService::arm() {
+  struct itimerspec spec;
+  memset(&spec, 0, sizeof(spec));
+  uint32_t when;
+  if (isSimulated() || !wheel_.nextEvent(when)) {
+    if (armed_) timerfd_settime(timerWatch_.fd_, 0, &spec, nullptr);
+    armed_ = false;
+    return;
+  }
+  if (armed_ && armedFor_ == when) return;
+
+  uint64_t nowNs = nanos();
+  uint64_t nowMs = nowNs / 1000000ull;
+  int32_t remaining = (int32_t)(when - (uint32_t)nowMs);
+  uint64_t deadline = remaining > 0 ? (nowMs + (uint64_t)remaining) * 1000000ull : nowNs;
+  spec.it_value.tv_sec = (time_t)(deadline / 1000000000ull);
+  spec.it_value.tv_nsec = (long)(deadline % 1000000000ull);
+  timerfd_settime(timerWatch_.fd_, TFD_TIMER_ABSTIME, &spec, nullptr);
+  armed_ = true;
+  armedFor_ = when;
+}
+
+size_t TimerService::runTimers() {
+  drainPosts();
+  return wheel_.tick();
+}
+
+int TimerService::runOnce(int maxWaitMs) {
+  if (!isOpen()) return -1;
+  int dispatched = (int)runTimers();
+  arm();
+
+  int waitMs = dispatched > 0 ? 0 : maxWaitMs;
+  if (waitMs != 0 && wheel_.activeCount() > 0 && isSimulated()) {
+    waitMs = waitMs < 0 || waitMs > kSimulatedPollMs ? kSimulatedPollMs : waitMs;
+  }
+
+  struct epoll_event events[kMaxEventsPerWait];
+  int count = epoll_wait(epollFd_, events, kMaxEventsPerWait, waitMs);
+  if (count < 0) {
+    if (errno != EINTR) return -1;
+    count = 0;
+  }
+
+  batch_ = events;
+  batchSize_ = count;
+  for (int i = 0; i < count; i++) {
+    FdWatch* watch = (FdWatch*)events[i].data.ptr;
+    if (watch == nullptr) continue;
+    if (watch == &timerWatch_) {
+      drainCounter(timerWatch_.fd_);
+      armed_ = false;
+    }
+    else if (watch == &wakeWatch_) {
+      drainCounter(wakeWatch_.fd_);
+    }
+    else if (watch->callback_ != nullptr) {
+      watch->callback_(*watch, events[i].events, watch->context_);
+      dispatched++;
+    }
+  }
+  batch_ = nullptr;
+  batchSize_ = 0;
+
+  dispatched += (int)runTimers();
+  arm();
+  return dispatched;
+}
+
+void TimerService::run() {
+  while (!stopRequested_.load(std::memory_order_acquire)) {
+    if (runOnce(-1) < 0) break;
+  }
+  stopRequested_.store(false, std::memory_order_relaxed);
+}
+
+void TimerService::requestStop() {
+  stopRequested_.store(true, std::memory_order_release);
+  if (isOpen()) wake();
+}
+
+bool TimerService::addFd(FdWatch& watch, int fd, uint32_t events) {
+  if (!isOpen() || !watchFd(epollFd_, EPOLL_CTL_ADD, fd, events, &watch)) return false;
+  watch.fd_ = fd;
+  watch.events_ = events;
+  return true;
+}
+
+bool TimerService::modifyFd(FdWatch& watch, uint32_t events) {
+  if (!isOpen() || watch.fd_ < 0 || !watchFd(epollFd_, EPOLL_CTL_MOD, watch.fd_, events, &watch)) return false;
+  watch.events_ = events;
+  return true;
+}
+
+bool TimerService::removeFd(FdWatch& watch) {
+  if (!isOpen() || watch.fd_ < 0) return false;
+  epoll_ctl(epollFd_, EPOLL_CTL_DEL, watch.fd_, nullptr);
+  // A callback may remove a watch whose event is later in the current batch
+  struct epoll_event* events = (struct epoll_event*)batch_;
+  for (int i = 0; i < batchSize_; i++) {
+    if (events[i].data.ptr == &watch) events[i].data.ptr = nullptr;
+  }
+  watch.fd_ = -1;
+  watch.events_ = 0;
+  return true;
+}
+
+#endif
@@ -0,0 +1,193 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./TimerWheel.h"
+
+#if defined(__linux__) && !defined(RT_HAS_ARDUINO)
+#define RT_HAS_TIMER_SERVICE 1
+
+#include <atomic>
+
+/**
+  * @brief A file descriptor watched by a TimerService.  Like WheelTimer the
+  *        node lives in the caller's object, so the service never allocates.
+  */
+class FdWatch
+{
+public:
+  typedef void (*Callback)(FdWatch& watch, uint32_t events, void* context);
+
+  FdWatch(Callback cb = nullptr, void* context = nullptr) :
+    fd_(-1), events_(0), callback_(cb), context_(context) {};
+
+  FdWatch(const FdWatch&) = delete;
+  FdWatch& operator=(const FdWatch&) = delete;
+
+  void setCallback(Callback cb, void* context = nullptr) {
+    callback_ = cb;
+    context_ = context;
+  }
+
+  int fd() const { return fd_; }
+
+  /**
+    * @brief The epoll events (EPOLLIN, EPOLLOUT, ...) being watched
+    */
+  uint32_t events() const { return events_; }
+
+protected:
+  friend class TimerService;
+
+  int fd_;
+  uint32_t events_;
+  Callback callback_;
+  void* context_;
+};
+
+/**
+  * @brief Millisecond timer event loop for Linux that sleeps instead of
+  *        polling.
+  *
+  *  Timers live in a TimerWheel.  A single timerfd is armed for the wheel's
+  *  next event and the loop blocks in epoll_wait() until it, or any other
+  *  watched descriptor, becomes ready.  All callbacks run on the thread that
+  *  calls run() or runOnce().
+  *
+  *  start() and stop() must be called on the loop thread (or before the loop
+  *  runs).  Other threads hand timers over with post() and postStop(), which
+  *  push onto a bounded lock-free queue and wake the loop through an eventfd;
+  *  a posted timer must not be touched by the posting thread until its
+  *  callback has run or it has been stopped.
+  *
+  *  While a SimulatedClock is in effect for the loop thread (normally one
+  *  installed with installGlobal()), the timerfd is not used: with timers
+  *  pending, the loop wakes every kSimulatedPollMs of real time to run
+  *  whatever the simulated time has made due.
+  *
+  * @code
+  * TimerService service;
+  * service.begin();
+  * WheelTimer heartbeat(onHeartbeat);
+  * service.start(heartbeat, 1000, 1000);
+  * service.run();
+  * @endcode
+  */
+class TimerService
+{
+public:
+  static constexpr size_t kPostQueueSize = 64; //!< Posts in flight before post() fails, a power of two
+  static constexpr int kMaxEventsPerWait = 16;
+  static constexpr int kSimulatedPollMs = 1; //!< Real time between checks of a SimulatedClock
+
+  TimerService();
+  ~TimerService();
+
+  /**
+    * @brief Creates the epoll, timer and wakeup descriptors
+    *
+    * @return false If any of them could not be created
+    */
+  bool begin();
+
+  /**
+    * @brief Closes the descriptors.  Active timers stay in the wheel.
+    */
+  void end();
+
+  bool isOpen() const { return epollFd_ >= 0; }
+
+  /**
+    * @brief Starts a timer; loop thread only
+    *
+    * @param delayMs Milliseconds until the first expiry
+    * @param periodMs Repeat period, 0 for a one shot timer
+    */
+  void start(WheelTimer& timer, uint32_t delayMs, uint32_t periodMs = 0);
+
+  /**
+    * @brief Stops a timer; loop thread only
+    */
+  void stop(WheelTimer& timer);
+
+  /**
+    * @brief Starts a timer from any thread
+    *
+    * @return false If the post queue is full
+    */
+  bool post(WheelTimer& timer, uint32_t delayMs, uint32_t periodMs = 0);
+
+  /**
+    * @brief Stops a timer from any thread
+    *
+    * @return false If the post queue is full
+    */
+  bool postStop(WheelTimer& timer);
+
+  /**
+    * @brief Watches a descriptor; the watch's callback runs on the loop
+    *        thread with the ready epoll events
+    *
+    * @param events EPOLLIN, EPOLLOUT, ... (level triggered unless EPOLLET is given)
+    */
+  bool addFd(FdWatch& watch, int fd, uint32_t events);
+  bool modifyFd(FdWatch& watch, uint32_t events);
+  bool removeFd(FdWatch& watch);
+
+  /**
+    * @brief Runs due timers, waits for the next timer or descriptor event and
+    *        dispatches it
+    *
+    * @param maxWaitMs Longest time to block, -1 to wait for the next event
+    * @return int The number of callbacks run, -1 if epoll_wait() failed
+    */
+  int runOnce(int maxWaitMs = -1);
+
+  /**
+    * @brief Calls runOnce() until requestStop()
+    */
+  void run();
+
+  /**
+    * @brief Makes run() return; safe from any thread and from callbacks
+    */
+  void requestStop();
+
+  TimerWheel<MillisClock>& wheel() { return wheel_; }
+
+protected:
+  enum class PostOp : uint8_t { Start, Stop };
+
+  struct PostSlot {
+    std::atomic<size_t> sequence;
+    WheelTimer* timer;
+    uint32_t issued; //!< millis() at the time of the post, delays count from here
+    uint32_t delay;
+    uint32_t period;
+    PostOp op;
+  };
+
+  TimerWheel<MillisClock> wheel_;
+  int epollFd_;
+  FdWatch timerWatch_;
+  FdWatch wakeWatch_;
+  bool armed_;
+  uint32_t armedFor_;
+  std::atomic<bool> stopRequested_;
+
+  PostSlot posts_[kPostQueueSize];
+  std::atomic<size_t> postHead_; //!< Next slot producers claim
+  size_t postTail_;              //!< Next slot the loop consumes
+
+  void* batch_;                  //!< epoll events being dispatched, so removeFd() can drop stale ones
+  int batchSize_;
+
+  void startFrom(uint32_t base, WheelTimer& timer, uint32_t delay, uint32_t period);
+  bool enqueue(PostOp op, WheelTimer& timer, uint32_t delay, uint32_t period);
+  void drainPosts();
+  void wake();
+  void arm();
+  bool isSimulated() const;
+  size_t runTimers();
+};
+
+#endif
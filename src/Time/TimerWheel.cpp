@@ -0,0 +1,180 @@
+#include "TimerWheel.h"
+#include <string.h>
+
+static inline int lowestBit(uint64_t v) {
+#if defined(__GNUC__) || defined(__clang__)
+  return __builtin_ctzll(v);
+#else
+  int n = 0;
+  while (!(v & 1)) {
+    v >>= 1;
+    n++;
+  }
+  return n;
+#endif
+}
+
+// Rotates the low width bits of v right by r, for a level of width slots
+static inline uint64_t rotateRight(uint64_t v, int r, int width) {
+  uint64_t mask = width == 64 ? ~0ull : (1ull << width) - 1;
+  return r == 0 ? v : ((v >> r) | (v << (width - r))) & mask;
+}
+
+void WheelTimer::stop() {
+  if (wheel_ != nullptr) wheel_->stop(*this);
+}
+
+TimerWheelBase::TimerWheelBase(uint32_t now) : current_(now), count_(0) {
+  memset(slots_, 0, sizeof(slots_));
+  memset(occupied_, 0, sizeof(occupied_));
+}
+
+void TimerWheelBase::start(WheelTimer& timer, uint32_t delay, uint32_t period) {
+  timer.stop();
+  if (delay > kMaxDelay) delay = kMaxDelay;
+  if (period > kMaxDelay) period = kMaxDelay;
+  timer.expires_ = current_ + (delay ? delay : 1);
+  timer.period_ = period;
+  timer.wheel_ = this;
+  insert(timer);
+}
+
+void TimerWheelBase::stop(WheelTimer& timer) {
+  if (timer.wheel_ != this) return;
+  if (timer.isActive()) unlink(timer);
+  timer.wheel_ = nullptr;
+}
+
+void TimerWheelBase::insert(WheelTimer& timer) {
+  uint32_t target = timer.expires_;
+  uint32_t delta = target - current_;
+  // Already overdue (a late periodic reschedule): run on the next tick.
+  // start() keeps delays below 2^31, so a fresh timer never takes this path
+  if ((int32_t)delta < 0) {
+    target = current_ + 1;
+    delta = 1;
+  }
+  int level = 0;
+  while (level < kLevels - 1 && (uint64_t)delta >= (1ull << (kLevelBits * (level + 1)))) level++;
+  int slot = (int)((target >> (kLevelBits * level)) & (kSlots - 1));
+
+  WheelTimer*& head = slots_[level][slot];
+  timer.next_ = head;
+  if (head != nullptr) head->pprev_ = &timer.next_;
+  head = &timer;
+  timer.pprev_ = &head;
+  occupied_[level] |= 1ull << slot;
+  count_++;
+}
+
+// Slots are not tracked per node, so an occupancy bit may outlive the last
+// timer in its slot; such stale bits cost one empty visit and are cleared then.
+void TimerWheelBase::unlink(WheelTimer& timer) {
+  *timer.pprev_ = timer.next_;
+  if (timer.next_ != nullptr) timer.next_->pprev_ = timer.pprev_;
+  timer.next_ = nullptr;
+  timer.pprev_ = nullptr;
+  count_--;
+}
+
+void TimerWheelBase::cascade(int level) {
+  int slot = (int)((current_ >> (kLevelBits * level)) & (kSlots - 1));
+  WheelTimer* list = slots_[level][slot];
+  slots_[level][slot] = nullptr;
+  occupied_[level] &= ~(1ull << slot);
+  if (list == nullptr) return;
+  list->pprev_ = &list;
+  while (list != nullptr) {
+    WheelTimer* timer = list;
+    unlink(*timer);
+    insert(*timer);
+  }
+}
+
+size_t TimerWheelBase::expireSlot(int slot) {
+  WheelTimer* pending = slots_[0][slot];
+  slots_[0][slot] = nullptr;
+  occupied_[0] &= ~(1ull << slot);
+  if (pending == nullptr) return 0;
+  // Callbacks may stop other pending timers; they unlink from this local list
+  pending->pprev_ = &pending;
+  size_t fired = 0;
+  while (pending != nullptr) {
+    WheelTimer* timer = pending;
+    unlink(*timer);
+    if (timer->period_) {
+      timer->expires_ += timer->period_;
+      if ((int32_t)(timer->expires_ - current_) <= 0) timer->expires_ = current_ + timer->period_;
+      insert(*timer);
+    }
+    else {
+      timer->wheel_ = nullptr;
+    }
+    if (timer->callback_ != nullptr) timer->callback_(*timer, timer->context_);
+    fired++;
+  }
+  return fired;
+}
+
+uint64_t TimerWheelBase::ticksToNextEvent() const {
+  uint64_t best = ~0ull;
+  for (int level = 0; level < kLevels; level++) {
+    if (!occupied_[level]) continue;
+    int shift = kLevelBits * level;
+    // The top level only has the 4 slots left of a 32 bit tick, so it
+    // rotates over those, not over kSlots
+    int slots = 32 - shift < kLevelBits ? 1 << (32 - shift) : kSlots;
+    int index = (int)((current_ >> shift) & (slots - 1));
+    // Slots strictly ahead of the current index, wrapping: an occupied slot
+    // equal to the index belongs to the next rotation.
+    int start = (index + 1) & (slots - 1);
+    uint64_t slotsAhead = (uint64_t)lowestBit(rotateRight(occupied_[level], start, slots)) + 1;
+    uint64_t withinSlot = current_ & ((1ull << shift) - 1);
+    uint64_t ticks = (slotsAhead << shift) - withinSlot;
+    if (ticks < best) best = ticks;
+  }
+  return best;
+}
+
+bool TimerWheelBase::nextEvent(uint32_t& when) const {
+  if (count_ == 0) return false;
+  uint64_t ticks = ticksToNextEvent();
+  when = current_ + (uint32_t)(ticks > 0xffffffffull ? 0xffffffffull : ticks);
+  return true;
+}
+
+size_t TimerWheelBase::advance(uint32_t now) {
+  uint32_t gap = now - current_;
+  if (gap == 0 || gap > 0u - kMaxLag) return 0;
+  // Every pending timer expires within kMaxDelay of the wheel's time, so a
+  // longer gap (a stall, or a fine clock) is crossed in steps of that size
+  size_t fired = 0;
+  while (gap > 0) {
+    uint32_t step = gap < kMaxDelay ? gap : kMaxDelay;
+    fired += advanceBy(step);
+    gap -= step;
+  }
+  return fired;
+}
+
+size_t TimerWheelBase::advanceBy(uint32_t ticks) {
+  uint32_t target = current_ + ticks;
+  size_t fired = 0;
+  while (current_ != target) {
+    if (count_ == 0) {
+      current_ = target;
+      break;
+    }
+    uint64_t step = ticksToNextEvent();
+    if (step > (uint64_t)(target - current_)) {
+      current_ = target;
+      break;
+    }
+    current_ += (uint32_t)step;
+    for (int level = kLevels - 1; level > 0; level--) {
+      if ((current_ & ((1ull << (kLevelBits * level)) - 1)) == 0) cascade(level);
+    }
+    fired += expireSlot((int)(current_ & (kSlots - 1)));
+  }
+  return fired;
+}
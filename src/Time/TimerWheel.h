@@ -0,0 +1,204 @@
+#pragma once
+
+#include "./TimeDeps.h"
+#include "./Clocks.h"
+
+class TimerWheelBase;
+
+/**
+  * @brief A timer node that lives in the user's own object and is linked
+  *        into a TimerWheel, so the wheel never allocates.
+  *
+  *  A timer may only be in one wheel at a time.  Destroying an active timer
+  *  removes it from its wheel.
+  */
+class WheelTimer
+{
+public:
+  typedef void (*Callback)(WheelTimer& timer, void* context);
+
+  WheelTimer(Callback cb = nullptr, void* context = nullptr) :
+    next_(nullptr), pprev_(nullptr), wheel_(nullptr), expires_(0), period_(0),
+    callback_(cb), context_(context) {};
+
+  /**
+    * @brief Copies the callback only; the copy is not active
+    */
+  WheelTimer(const WheelTimer& other) :
+    next_(nullptr), pprev_(nullptr), wheel_(nullptr), expires_(0), period_(0),
+    callback_(other.callback_), context_(other.context_) {};
+
+  WheelTimer& operator=(const WheelTimer&) = delete;
+
+  ~WheelTimer() { stop(); }
+
+  void setCallback(Callback cb, void* context = nullptr) {
+    callback_ = cb;
+    context_ = context;
+  }
+
+  /**
+    * @brief Removes the timer from its wheel if it is active
+    */
+  void stop();
+
+  bool isActive() const { return pprev_ != nullptr; }
+
+  /**
+    * @brief The wheel time at which the timer expires next
+    */
+  uint32_t expiry() const { return expires_; }
+
+  /**
+    * @brief The repeat period in ticks, 0 for a one shot timer
+    */
+  uint32_t period() const { return period_; }
+
+protected:
+  friend class TimerWheelBase;
+
+  WheelTimer* next_;
+  WheelTimer** pprev_;      //!< The pointer that points at this node, for O(1) unlinking
+  TimerWheelBase* wheel_;
+  uint32_t expires_;
+  uint32_t period_;
+  Callback callback_;
+  void* context_;
+};
+
+/**
+  * @brief A WheelTimer that calls a functor, in the style of BasicTimer::onExpire()
+  *
+  * @code
+  * auto blink = makeWheelTimer([&] { led.toggle(); });
+  * wheel.start(blink, 500, 500);
+  * @endcode
+  */
+template<typename Functor>
+class FunctorWheelTimer : public WheelTimer
+{
+public:
+  FunctorWheelTimer(Functor fn) : WheelTimer(&invoke), fn_(fn) {};
+
+  FunctorWheelTimer(const FunctorWheelTimer& other) : WheelTimer(&invoke), fn_(other.fn_) {};
+
+protected:
+  Functor fn_;
+
+  static void invoke(WheelTimer& timer, void*) {
+    static_cast<FunctorWheelTimer&>(timer).fn_();
+  }
+};
+
+template<typename Functor>
+FunctorWheelTimer<Functor> makeWheelTimer(Functor fn) {
+  return FunctorWheelTimer<Functor>(fn);
+}
+
+/**
+  * @brief Hierarchical timing wheel (Varghese & Lauck) over 32 bit ticks.
+  *
+  *  Six levels of 64 slots cover the whole 32 bit range.  Starting and
+  *  stopping a timer are O(1) list operations.  Level 0 slots hold timers due
+  *  within the next 64 ticks; when a level's index wraps, the matching slot of
+  *  the level above is redistributed ("cascaded") downwards.  An occupancy
+  *  bit mask per level lets advance() jump straight to the next slot that has
+  *  work, so a call only touches timers that are due (plus the occasional
+  *  cascade) no matter how many are pending.
+  *
+  *  Delays are measured from the wheel's own time, which is the time passed
+  *  to the last advance().  Delays and periods are limited to kMaxDelay
+  *  (2^31 - 1 ticks) so that expiry times compare correctly across the
+  *  32 bit wrap; that is about 24 days of milliseconds, 35 minutes of
+  *  microseconds or 2.1 seconds of nanoseconds.
+  *
+  *  advance() itself may be called after any gap shorter than the 32 bit
+  *  wrap, longer ones included: the wheel crosses them in kMaxDelay steps.
+  *  Only a time up to kMaxLag ticks before the wheel's is taken as a stale
+  *  reading and ignored.
+  */
+class TimerWheelBase
+{
+public:
+  static constexpr int kLevelBits = 6;
+  static constexpr int kSlots = 1 << kLevelBits;
+  static constexpr int kLevels = 6;
+  static constexpr uint32_t kMaxDelay = 0x7fffffff;
+  static constexpr uint32_t kMaxLag = 0x10000; //!< How far behind advance() may be passed a time
+
+  TimerWheelBase(uint32_t now);
+
+  /**
+    * @brief Starts (or restarts) a timer
+    *
+    * @param timer The timer to schedule
+    * @param delay Ticks from the wheel's current time until expiry, at least 1;
+    *        clamped to kMaxDelay
+    * @param period Repeat period in ticks, 0 for a one shot timer; clamped to
+    *        kMaxDelay
+    */
+  void start(WheelTimer& timer, uint32_t delay, uint32_t period = 0);
+
+  void stop(WheelTimer& timer);
+
+  /**
+    * @brief Moves the wheel's time forward to now, running the callback of
+    *        every timer that expires on the way, in expiry order.  Does
+    *        nothing if now is at most kMaxLag ticks behind the wheel's time.
+    *
+    * @return size_t The number of callbacks run
+    */
+  size_t advance(uint32_t now);
+
+  /**
+    * @brief The wheel's current time
+    */
+  uint32_t now() const { return current_; }
+
+  size_t activeCount() const { return count_; }
+
+  /**
+    * @brief The next time at which advance() has work to do, which is never
+    *        later than the earliest expiry.
+    *
+    * @return false If no timer is active
+    */
+  bool nextEvent(uint32_t& when) const;
+
+protected:
+  WheelTimer* slots_[kLevels][kSlots];
+  uint64_t occupied_[kLevels];
+  uint32_t current_;
+  size_t count_;
+
+  void insert(WheelTimer& timer);
+  void unlink(WheelTimer& timer);
+  void cascade(int level);
+  size_t expireSlot(int slot);
+  size_t advanceBy(uint32_t ticks);
+  uint64_t ticksToNextEvent() const;
+};
+
+/**
+  * @brief A TimerWheel driven by a clock policy
+  *
+  * @tparam Clock The clock policy (see Time/Clocks.h), one wheel tick is one
+  *         clock tick.  Clocks wider than 32 bits are truncated, which the
+  *         wheel's wrap-safe arithmetic tolerates; delays stay limited to
+  *         kMaxDelay ticks.
+  */
+template<typename Clock = MillisClock>
+class TimerWheel : public TimerWheelBase
+{
+public:
+  TimerWheel() : TimerWheelBase((uint32_t)Clock::now()) {};
+
+  /**
+    * @brief Advances the wheel to the clock's current time
+    *
+    * @return size_t The number of callbacks run
+    */
+  size_t tick() {
+    return advance((uint32_t)Clock::now());
+  }
+};